@@ -0,0 +1,95 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+struct arena_block
+{
+  struct arena_block *next;
+  size_t size;
+  size_t used;
+};
+
+// The header takes the first ARENA_ALIGN bytes of the block
+#define ARENA_HEADER                                                           \
+  ((sizeof(struct arena_block) + ARENA_ALIGN - 1) & -ARENA_ALIGN)
+
+static struct arena_block *arena_block_map(size_t size)
+{
+  void *p = MAP_FAILED;
+
+#if ARENA_HUGE_PAGES
+  size = (size + (2 << 20) - 1) & -(2 << 20);
+  p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p == MAP_FAILED)
+  {
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+             -1, 0);
+    if (p != MAP_FAILED)
+      madvise(p, size, MADV_HUGEPAGE);
+  }
+#else
+  p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+           -1, 0);
+#endif
+
+  if (p == MAP_FAILED)
+    return NULL;
+
+  struct arena_block *block = p;
+  block->size = size;
+  block->used = ARENA_HEADER;
+  return block;
+}
+
+void arena_init(struct arena *arena)
+{
+  arena->head = NULL;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+  size = (size + ARENA_ALIGN - 1) & -ARENA_ALIGN;
+
+  struct arena_block *block = arena->head;
+  if (!block || block->size - block->used < size)
+  {
+    size_t block_size = ARENA_HEADER + size;
+    if (block_size < ARENA_BLOCK_SIZE)
+      block_size = ARENA_BLOCK_SIZE;
+
+    block = arena_block_map(block_size);
+    if (!block)
+      return NULL;
+
+    // keep filling the current block if the new one is only for this
+    // request
+    if (arena->head && block->size - ARENA_HEADER == size)
+    {
+      block->next = arena->head->next;
+      arena->head->next = block;
+    }
+    else
+    {
+      block->next = arena->head;
+      arena->head = block;
+    }
+  }
+
+  void *p = (char *)block + block->used;
+  block->used += size;
+  return p;
+}
+
+void arena_free(struct arena *arena)
+{
+  struct arena_block *block = arena->head;
+  while (block)
+  {
+    struct arena_block *next = block->next;
+    munmap(block, block->size);
+    block = next;
+  }
+  arena->head = NULL;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Per-run arena
+ *
+ * Every buffer whose size is known when an optimization starts is carved
+ * out of a few large blocks owned by the arena, and released all at once by
+ * arena_free. Allocations bump a pointer, are ARENA_ALIGN bytes aligned and
+ * are not zeroed (but fresh blocks come from mmap, so they read as zero).
+ *
+ * With ARENA_HUGE_PAGES, blocks are multiples of 2 MB and backed by huge
+ * pages: reserved ones (MAP_HUGETLB) when available, otherwise the kernel
+ * is asked to back them with transparent huge pages.
+ */
+
+#ifndef ARENA_HUGE_PAGES
+#define ARENA_HUGE_PAGES 0
+#endif
+
+#define ARENA_ALIGN 64
+// Smallest block, larger requests get a block of their own
+#define ARENA_BLOCK_SIZE (2 << 20)
+
+struct arena_block;
+
+struct arena
+{
+  // most recent block first
+  struct arena_block *head;
+};
+
+void arena_init(struct arena *arena);
+void *arena_alloc(struct arena *arena, size_t size);
+// Release every allocation of the arena
+void arena_free(struct arena *arena);
@@ -0,0 +1,133 @@
+#include "ask_tell.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "steps/steps.h"
+
+// Points found in the evaluation cache are told right away, only the others
+// are asked for.
+static void ask_tell_pending(struct pso_data_constant_inertia *pso, int phase,
+                             double const *x, size_t n)
+{
+  int dim = pso->dimensions;
+
+  pso->phase = phase;
+  pso->pending_n = n;
+  pso->pending_told_n = 0;
+  pso->pending_ask_n = 0;
+
+  for (size_t k = 0; k < n; ++k)
+  {
+    ssize_t idx = eval_cache_find(pso, x + k * dim);
+    if (0 <= idx)
+    {
+      pso->pending_eval[k] = pso->x_distinct_eval[idx];
+      pso->pending_told_n++;
+      continue;
+    }
+    size_t a = pso->pending_ask_n++;
+    memcpy(pso->pending_ask_x + a * dim, x + k * dim, dim * sizeof(double));
+    pso->pending_ask_map[a] = k;
+    pso->pending_told[a] = 0;
+  }
+  pso->eval_cache.hits += pso->pending_told_n;
+  pso->eval_cache.misses += pso->pending_ask_n;
+}
+
+// steps 5 and 6, up to the evaluation of the new positions
+static void ask_tell_iteration(struct pso_data_constant_inertia *pso)
+{
+  if (pso->time < pso->time_max - 1)
+  {
+    step5_optimized(pso);
+    step6_optimized(pso);
+    ask_tell_pending(pso, PSO_PHASE_SWARM, pso->x, pso->population_size);
+  }
+  else
+  {
+    pso->phase = PSO_PHASE_DONE;
+    pso->pending_n = pso->pending_ask_n = 0;
+  }
+}
+
+// Run the steps that consume the evaluations of the batch, until the next
+// batch that is not entirely cached.
+static void ask_tell_advance(struct pso_data_constant_inertia *pso)
+{
+  size_t pop_size = pso->population_size;
+
+  while (pso->phase != PSO_PHASE_DONE &&
+         pso->pending_told_n == pso->pending_n)
+  {
+    switch (pso->phase)
+    {
+    case PSO_PHASE_SFD:
+      step1_2_tell(pso, pso->sfd_size, pso->sfd, pso->pending_eval);
+      step3(pso);
+      ask_tell_pending(pso, PSO_PHASE_INIT, pso->x, pop_size);
+      break;
+
+    case PSO_PHASE_INIT:
+      memcpy(pso->x_eval, pso->pending_eval, pop_size * sizeof(double));
+      step4_tell(pso);
+      ask_tell_iteration(pso);
+      break;
+
+    case PSO_PHASE_SWARM:
+      memcpy(pso->x_eval, pso->pending_eval, pop_size * sizeof(double));
+      step8_optimized(pso);
+      step9_optimized(pso);
+      step10_optimized(pso);
+      if (step11_ask(pso))
+        ask_tell_pending(pso, PSO_PHASE_REFINE, pso->x_local, pso->x_local_n);
+      else
+        ask_tell_iteration(pso);
+      break;
+
+    case PSO_PHASE_REFINE:
+      step11_tell(pso, pso->pending_eval);
+      ask_tell_iteration(pso);
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+void pso_ask_tell_start(struct pso_data_constant_inertia *pso,
+                        size_t sfd_size, double *space_filling_design)
+{
+  size_t max_n = MAX(sfd_size, (size_t)pso->population_size);
+  struct arena *arena = &pso->arena;
+  pso->pending_eval = arena_alloc(arena, max_n * sizeof(double));
+  pso->pending_ask_x =
+      arena_alloc(arena, max_n * pso->dimensions * sizeof(double));
+  pso->pending_ask_map = arena_alloc(arena, max_n * sizeof(size_t));
+  pso->pending_told = arena_alloc(arena, max_n);
+  pso->sfd = space_filling_design;
+  pso->sfd_size = sfd_size;
+
+  ask_tell_pending(pso, PSO_PHASE_SFD, space_filling_design, sfd_size);
+  ask_tell_advance(pso);
+}
+
+size_t pso_ask(struct pso_data_constant_inertia *pso, double const **x)
+{
+  *x = pso->pending_ask_x;
+  return pso->pending_ask_n;
+}
+
+void pso_tell(struct pso_data_constant_inertia *pso, size_t k, double fx)
+{
+  assert(k < pso->pending_ask_n);
+  if (pso->pending_told[k])
+    return;
+  pso->pending_told[k] = 1;
+  pso->pending_eval[pso->pending_ask_map[k]] = fx;
+  pso->pending_told_n++;
+
+  ask_tell_advance(pso);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "pso.h"
+
+/*
+ * Ask/tell interface
+ *
+ * Runs the same steps as run_pso, but instead of calling pso->f each
+ * evaluation batch (the space filling design, the initial swarm, the swarm
+ * of every iteration and the local refinement point) is handed out to the
+ * caller:
+ *
+ *   pso_constant_inertia_init(&pso, NULL, ...);
+ *   pso_ask_tell_start(&pso, sfd_size, space_filling_design);
+ *   while ((n = pso_ask(&pso, &x)))
+ *     for (k = 0; k < n; k++)
+ *       pso_tell(&pso, k, f(x + k * dimensions));
+ *   pso_destroy(&pso);
+ *
+ * The evaluations of a batch may be told in any order, the surrogate steps
+ * run once the last one arrives. Points found in the evaluation cache are
+ * not asked for. The result is the same as with run_pso.
+ */
+
+enum pso_phase
+{
+  PSO_PHASE_SFD,    // step 1-2: the space filling design
+  PSO_PHASE_INIT,   // step 4: the initial positions
+  PSO_PHASE_SWARM,  // step 7: the positions of an iteration
+  PSO_PHASE_REFINE, // step 11: the minimizer of the surrogate
+  PSO_PHASE_DONE
+};
+
+// space_filling_design must stay valid until its batch is told
+void pso_ask_tell_start(struct pso_data_constant_inertia *pso,
+                        size_t sfd_size, double *space_filling_design);
+
+/** @brief The points of the pending batch waiting for evaluations.
+ *
+ * @param pso: The pso state.
+ * @param x: Set to the points, row by row. They stay valid and unchanged
+ *           until the last evaluation of the batch is told.
+ * @return: The number of points, 0 once the optimization is over.
+ */
+size_t pso_ask(struct pso_data_constant_inertia *pso, double const **x);
+
+/** @brief Give the evaluation of point k of those returned by pso_ask.
+ *
+ * Evaluations of points already told are ignored. The last one runs the
+ * steps up to the next batch.
+ */
+void pso_tell(struct pso_data_constant_inertia *pso, size_t k, double fx);
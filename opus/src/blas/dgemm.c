@@ -16,6 +16,7 @@
 #endif
 
 #include "../helpers.h"
+#include "../threads.h"
 
 // M N K block sizes for scratch buffers
 #if !defined(M_BLOCK) || !defined(N_BLOCK) || !defined(K_BLOCK)
@@ -31,28 +32,35 @@
 #define K_BLOCK 384
 #endif
 
-static double *scratch_a;
-static double *scratch_b;
-
-void dgemm_initialize_memory(int max_n)
+double *dgemm_alloc_work()
 {
-  // XXX align the scratch buffers to the page size to avoid any potential
+  // XXX align the packing buffers to the page size to avoid any potential
   // page misses.
-  scratch_a = (double *)aligned_alloc(
-      4096, (M_BLOCK * K_BLOCK * sizeof(double) + 4095) & -4096);
-  scratch_b = (double *)aligned_alloc(
-      4096, (K_BLOCK * N_BLOCK * sizeof(double) + 4095) & -4096);
+  int threads = omp_get_max_threads();
+  size_t size = DGEMM_WORK_SIZE;
+  if (threads > 1)
+    size = ((DGEMM_WORK_SIZE + 511) & -512) + (threads - 1) * DGEMM_WORK_B;
+
+  // one more page in front for the thread count
+  double *page =
+      aligned_alloc(4096, 4096 + ((size * sizeof(double) + 4095) & -4096));
+  if (!page)
+    return NULL;
+  *(int *)page = threads;
+  return page + 512;
 }
 
-void dgemm_free_memory()
+void dgemm_free_work(double *work)
 {
-  free(scratch_a);
-  free(scratch_b);
+  if (work)
+    free(work - 512);
 }
 
 void dgemm_1(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC)
+             int LDB, double beta, double *C, int LDC, double *work)
 {
+  // no packing
+  (void)work;
 
   // NOTE as written below, we specialize to alpha = -1 beta = 1
   assert(APPROX_EQUAL(beta, ONE));
@@ -96,8 +104,11 @@ void dgemm_1T(int M, int N, int K, double alpha, double *A, int LDA, double *B,
 
 void dgemm_2(int M, int N, int K, double alpha, double *restrict A, int LDA,
              double *restrict B, int LDB, double beta, double *restrict C,
-             int LDC)
+             int LDC, double *work)
 {
+  // no packing
+  (void)work;
+
   // NOTE as written below, we specialize to alpha = -1 beta = 1
   assert(APPROX_EQUAL(beta, ONE));
   assert(APPROX_EQUAL(alpha, -ONE));
@@ -750,10 +761,10 @@ void dgemm_2(int M, int N, int K, double alpha, double *restrict A, int LDA,
 }
 
 void dgemm_3(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC)
+             int LDB, double beta, double *C, int LDC, double *work)
 {
-  double *AL = scratch_a;
-  double *BL = scratch_b;
+  double *AL = work;
+  double *BL = work + DGEMM_WORK_B;
 
   // Deltas for blocking
   int i, j, k, //
@@ -790,10 +801,10 @@ static void pack_4(double *dst, double *src, int LDA, int M, int N)
 
 void dgemm_4(int M, int N, int K, double alpha, double *restrict A, int LDA,
              double *restrict B, int LDB, double beta, double *restrict C,
-             int LDC)
+             int LDC, double *work)
 {
-  double *AL = scratch_a;
-  double *BL = scratch_b;
+  double *AL = work;
+  double *BL = work + DGEMM_WORK_B;
 
   // Deltas for blocking
   int i, j, k, //
@@ -1542,10 +1553,10 @@ static void pack_b_5(double *dst, double *src, int LDA, int M, int N)
 
 void dgemm_5(int M, int N, int K, double alpha, double *restrict A, int LDA,
              double *restrict B, int LDB, double beta, double *restrict C,
-             int LDC)
+             int LDC, double *work)
 {
-  double *AL = scratch_a;
-  double *BL = scratch_b;
+  double *AL = work;
+  double *BL = work + DGEMM_WORK_B;
 
   // Deltas for blocking
   int i, j, k, //
@@ -2290,10 +2301,10 @@ static void pack_b_6(double *dst, double *src, int LDA, int M, int N)
 // XXX so far nothing has been obiously successful.
 void dgemm_6(int M, int N, int K, double alpha, double *restrict A, int LDA,
              double *restrict B, int LDB, double beta, double *restrict C,
-             int LDC)
+             int LDC, double *work)
 {
-  double *AL = scratch_a;
-  double *BL = scratch_b;
+  double *AL = work;
+  double *BL = work + DGEMM_WORK_B;
 
   // Deltas for blocking
   int i, j, k, //
@@ -2320,6 +2331,83 @@ void dgemm_6(int M, int N, int K, double alpha, double *restrict A, int LDA,
   }
 }
 
+// DGEMM 7 runs the tiles of dgemm_6 in parallel. Every block of B is
+// packed once by all the threads, then each thread updates whole tiles of C
+// (M_BLOCK rows, a share of the columns) with its own packed block of A.
+void dgemm_7(int M, int N, int K, double alpha, double *restrict A, int LDA,
+             double *restrict B, int LDB, double beta, double *restrict C,
+             int LDC, double *work)
+{
+  // NOTE as written below, we specialize to alpha = -1 beta = 1
+  assert(APPROX_EQUAL(beta, ONE));
+  assert(APPROX_EQUAL(alpha, -ONE));
+
+  double *BL = work + DGEMM_WORK_B;
+
+  // the thread count may have grown since work was allocated
+  const int threads = MIN(omp_get_max_threads(), DGEMM_WORK_THREADS(work)), //
+      n_i = (M + M_BLOCK - 1) / M_BLOCK;
+
+  // Deltas for blocking
+  int j, k, //
+      d_j, d_k;
+
+  // A[M, K] B[K, N] C[M, N]
+  for (j = 0; j < N; j += d_j)
+  {
+    d_j = MIN(N - j, N_BLOCK);
+
+    // split the columns until every thread has a tile, in multiples of 4
+    // columns to cut the packed block of B between its panels
+    int n_j = MIN((threads + n_i - 1) / n_i, (d_j + 3) / 4);
+    int w_j = ((d_j + n_j - 1) / n_j + 3) & -4;
+    n_j = (d_j + w_j - 1) / w_j;
+
+    for (k = 0; k < K; k += d_k)
+    {
+      d_k = MIN(K - k, K_BLOCK);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)                                      \
+    if ((double)M * d_j * d_k >= DGEMM_PARALLEL_MIN)
+#endif
+      {
+        double *AL = DGEMM_WORK_A(work, omp_get_thread_num());
+        int packed_i = -1;
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int jj = 0; jj < d_j; jj += 4)
+          pack_b_6(BL + jj * d_k, &TIX(B, LDB, k, j + jj), LDB, d_k,
+                   MIN(d_j - jj, 4));
+
+        // consecutive tiles of a thread share their rows, A is packed once
+#ifdef _OPENMP
+#pragma omp for collapse(2) schedule(static)
+#endif
+        for (int ii = 0; ii < n_i; ii++)
+        {
+          for (int jj = 0; jj < n_j; jj++)
+          {
+            int i0 = ii * M_BLOCK, j0 = jj * w_j;
+            int d_i = MIN(M - i0, M_BLOCK);
+            if (packed_i != ii)
+            {
+              pack_a_6(AL, &TIX(A, LDA, i0, k), LDA, d_i, d_k);
+              packed_i = ii;
+            }
+            dgemm_6_mini(d_i, MIN(d_j - j0, w_j), d_k, //
+                         AL, -10E5,          // NOTE these shouldn't be used
+                         BL + j0 * d_k, -10E5,                 //
+                         &TIX(C, LDC, i0, j + j0), LDC);
+          }
+        }
+      }
+    }
+  }
+}
+
 // -----------
 // END OF IMPL
 // -----------
@@ -2327,7 +2415,8 @@ void dgemm_6(int M, int N, int K, double alpha, double *restrict A, int LDA,
 #ifdef TEST_MKL
 
 void dgemm_intel(int M, int N, int K, double alpha, double *A, int LDA,
-                 double *B, int LDB, double beta, double *C, int LDC)
+                 double *B, int LDB, double beta, double *C, int LDC,
+                 double *work)
 {
   // Update trailing submatrix
   cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, M, N, K, alpha, A, LDA,
@@ -2335,7 +2424,8 @@ void dgemm_intel(int M, int N, int K, double alpha, double *A, int LDA,
 }
 
 void dgemm_intelT(int M, int N, int K, double alpha, double *A, int LDA,
-                  double *B, int LDB, double beta, double *C, int LDC)
+                  double *B, int LDB, double beta, double *C, int LDC,
+                  double *work)
 {
   // Update trailing submatrix
   cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, M, N, K, alpha, A, LDA,
@@ -2371,6 +2461,11 @@ void register_functions_MMM()
           M_BLOCK, N_BLOCK, K_BLOCK);
   add_function_MMM(&dgemm_6, name, 1);
 
+  // one curve per OMP_NUM_THREADS
+  sprintf(name, "%s (%d %d %d) x%d", "MMM C Vector Virtual Pack Parallel", //
+          M_BLOCK, N_BLOCK, K_BLOCK, omp_get_max_threads());
+  add_function_MMM(&dgemm_7, name, 1);
+
 #ifdef TEST_MKL
   add_function_MMM(&dgemm_intel, "MMM_Intel RowMjr", 1);
   add_function_MMM(&dgemm_intelT, "MMM_Intel ColMjr", 1);
@@ -14,31 +14,64 @@
  * @param beta Scalar beta.
  * @param C Real valued MxN matrix C.
  * @param Leading dimension of C.
+ * @param work Packing workspace of DGEMM_WORK_SIZE doubles, from
+ *             dgemm_alloc_work.
  */
 void dgemm(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-           int LDB, double beta, double *C, int LDC);
+           int LDB, double beta, double *C, int LDC, double *work);
 #endif
 
-void dgemm_initialize_memory(int max_n);
-void dgemm_free_memory();
+// The packed block of A is followed by the packed block of B, both page
+// aligned. dgemm_7 packs the blocks of A of the threads t > 0 after them.
+#define DGEMM_WORK_B ((M_BLOCK * K_BLOCK + 511) & -512)
+#define DGEMM_WORK_SIZE (DGEMM_WORK_B + K_BLOCK * N_BLOCK)
+#define DGEMM_WORK_A(work, t)                                                  \
+  ((t) ? (work) + ((DGEMM_WORK_SIZE + 511) & -512) + ((t)-1) * DGEMM_WORK_B    \
+       : (work))
+
+// Products of fewer multiply-adds run dgemm_7 on a single thread
+#ifndef DGEMM_PARALLEL_MIN
+#define DGEMM_PARALLEL_MIN (1 << 21)
+#endif
+
+// Workspace for omp_get_max_threads() threads, release with dgemm_free_work
+double *dgemm_alloc_work();
+void dgemm_free_work(double *work);
+
+// Number of threads dgemm_alloc_work sized work for, kept in the page before
+// it
+#define DGEMM_WORK_THREADS(work) (*(int const *)((work)-512))
 
 void dgemm_1(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 void dgemm_2(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 void dgemm_3(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 void dgemm_4(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 void dgemm_5(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 void dgemm_6(int M, int N, int K, double alpha, double *A, int LDA, double *B,
-             int LDB, double beta, double *C, int LDC);
+             int LDB, double beta, double *C, int LDC,
+             double *work);
+// dgemm_6 on omp_get_max_threads() threads, at most DGEMM_WORK_THREADS(work),
+// sharing the packed block of B
+void dgemm_7(int M, int N, int K, double alpha, double *A, int LDA, double *B,
+             int LDB, double beta, double *C, int LDC,
+             double *work);
 
 void dgemm_intel(int M, int N, int K, double alpha, double *A, int LDA,
-                 double *B, int LDB, double beta, double *C, int LDC);
+                 double *B, int LDB, double beta, double *C, int LDC,
+                 double *work);
 void dgemm_intelT(int M, int N, int K, double alpha, double *A, int LDA,
-                  double *B, int LDB, double beta, double *C, int LDC);
+                  double *B, int LDB, double beta, double *C, int LDC,
+                  double *work);
 
 #ifdef TEST_PERF
 
@@ -0,0 +1,80 @@
+#include <immintrin.h>
+#include <math.h>
+
+#include "../helpers.h"
+#include "dgeqr2.h"
+
+// Sum of X[i] * Y[i]
+static inline double ddot_6(int M, double *X, double *Y)
+{
+  int i = 0;
+  double s;
+  __m256d s0 = _mm256_setzero_pd(), s4 = _mm256_setzero_pd();
+  double acc[4] __attribute__((aligned(32)));
+
+  for (; i <= M - 8; i += 8)
+  {
+    s0 = _mm256_fmadd_pd(_mm256_loadu_pd(X + i + 0),
+                         _mm256_loadu_pd(Y + i + 0), s0);
+    s4 = _mm256_fmadd_pd(_mm256_loadu_pd(X + i + 4),
+                         _mm256_loadu_pd(Y + i + 4), s4);
+  }
+  _mm256_store_pd(acc, _mm256_add_pd(s0, s4));
+  s = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+  for (; i < M; ++i)
+    s += X[i] * Y[i];
+  return s;
+}
+
+// Y := Y - s * X
+static inline void daxpy_neg_6(int M, double s, double *X, double *Y)
+{
+  int i = 0;
+  __m256d sp = _mm256_set1_pd(s);
+
+  for (; i <= M - 4; i += 4)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i), y0);
+    _mm256_storeu_pd(Y + i, y0);
+  }
+  for (; i < M; ++i)
+    Y[i] -= s * X[i];
+}
+
+void dgeqr2_6(int M, int N, double *A, int LDA, double *tau)
+{
+  int i, j, k;
+  double alpha, beta, xnorm, scale, w;
+
+  for (i = 0; i < MIN(M, N); ++i)
+  {
+    // Generate H_i to annihilate A(i+1:M, i)
+    double *x = &TIX(A, LDA, i + 1, i);
+    alpha = TIX(A, LDA, i, i);
+    xnorm = sqrt(ddot_6(M - i - 1, x, x));
+
+    if (APPROX_EQUAL(xnorm, 0.))
+    {
+      tau[i] = 0.;
+      continue;
+    }
+
+    beta = -copysign(sqrt(alpha * alpha + xnorm * xnorm), alpha);
+    tau[i] = (beta - alpha) / beta;
+    scale = 1. / (alpha - beta);
+    for (k = 0; k < M - i - 1; ++k)
+      x[k] *= scale;
+    TIX(A, LDA, i, i) = beta;
+
+    // Apply H_i to A(i:M, i+1:N) from the left
+    for (j = i + 1; j < N; ++j)
+    {
+      double *y = &TIX(A, LDA, i + 1, j);
+      w = tau[i] * (TIX(A, LDA, i, j) + ddot_6(M - i - 1, x, y));
+      TIX(A, LDA, i, j) -= w;
+      daxpy_neg_6(M - i - 1, w, x, y);
+    }
+  }
+}
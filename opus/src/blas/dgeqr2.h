@@ -0,0 +1,19 @@
+#pragma once
+
+#if 0
+// Equivalent to DGEQR2.
+/** @brief Householder QR factorization A = Q * R of a tall M x N matrix
+ *         (M >= N) using BLAS2 operations. After exit R is stored in the
+ *         upper triangle of A and the reflectors H_i = I - tau_i v_i v_i^T
+ *         below the diagonal (v_i(i) = 1 is not stored).
+ *
+ * @param M The number of rows (height) of A.
+ * @param N The number of columns (width) of A.
+ * @param A Real valued matrix (transposed layout).
+ * @param LDA The leading dimension of A.
+ * @param tau Output buffer for the N scalar factors of the reflectors.
+ */
+void dgeqr2(int M, int N, double *A, int LDA, double *tau);
+#endif
+
+void dgeqr2_6(int M, int N, double *A, int LDA, double *tau);
@@ -2,8 +2,11 @@
 #include <math.h>
 
 #include "../helpers.h"
+#include "dgemm.h"
 #include "dgetf2.h"
+#include "dlaswp.h"
 #include "dswap.h"
+#include "dtrsm.h"
 #include "idamax.h"
 
 int dgetf2_1(int M, int N, double *A, int LDA, int *ipiv)
@@ -463,3 +466,150 @@ int dgetf2_6(int M, int N, double *A, int LDA, int *ipiv)
 
   return 0;
 }
+
+// A(i + 1 : M, k) -= A(i + 1 : M, i) * A(i, k), returns the first row of
+// the largest updated entry in absolute value (M if there is none)
+static int dgetf2_7_update_amax(int M, int i, int k, double *A, int LDA)
+{
+  int j;
+  double *l = &TIX(A, LDA, 0, i), *c = &TIX(A, LDA, 0, k);
+  double a_ik = TIX(A, LDA, i, k), best = -1., best_j = M, v;
+
+  __m256d a_ik_p = _mm256_set1_pd(a_ik), //
+      sign_p = _mm256_set1_pd(-0.),      //
+      best_p = _mm256_set1_pd(-1.),      //
+      best_jp = _mm256_set1_pd(M),       //
+      four_p = _mm256_set1_pd(4.),       //
+      j_p, c_p, abs_p, gt_p;
+
+  j = i + 1;
+  j_p = _mm256_setr_pd(j, j + 1, j + 2, j + 3);
+  for (; j + 4 <= M; j += 4)
+  {
+    c_p = _mm256_fnmadd_pd(_mm256_loadu_pd(l + j), a_ik_p,
+                           _mm256_loadu_pd(c + j));
+    _mm256_storeu_pd(c + j, c_p);
+
+    // strictly larger, each lane keeps its first maximum
+    abs_p = _mm256_andnot_pd(sign_p, c_p);
+    gt_p = _mm256_cmp_pd(abs_p, best_p, _CMP_GT_OQ);
+    best_p = _mm256_blendv_pd(best_p, abs_p, gt_p);
+    best_jp = _mm256_blendv_pd(best_jp, j_p, gt_p);
+    j_p = _mm256_add_pd(j_p, four_p);
+  }
+
+  double lanes[4], lanes_j[4];
+  _mm256_storeu_pd(lanes, best_p);
+  _mm256_storeu_pd(lanes_j, best_jp);
+  for (int q = 0; q < 4; ++q)
+  {
+    // on a tie the lowest row wins, as in idamax
+    int tie = !(best < lanes[q]) && !(lanes[q] < best);
+    if (best < lanes[q] || (tie && lanes_j[q] < best_j))
+      best = lanes[q], best_j = lanes_j[q];
+  }
+
+  for (; j < M; ++j)
+  {
+    c[j] -= l[j] * a_ik;
+    v = fabs(c[j]);
+    if (best < v)
+      best = v, best_j = j;
+  }
+
+  return (int)best_j;
+}
+
+// dgetf2_6 for narrow panels: the pivot of column i + 1 is searched while
+// the rank 1 update of step i writes it
+static int dgetf2_7_base(int M, int N, double *A, int LDA, int *ipiv)
+{
+  int i, j, k, p_i;
+  double p_v, m_0;
+  __m256d m_0p;
+
+  if (!M || !N)
+    return 0;
+
+  p_i = idamax_2(M, A, 1);
+
+  for (i = 0; i < MIN(M, N); ++i)
+  {
+    p_v = TIX(A, LDA, p_i, i);
+
+    if (APPROX_EQUAL(p_v, 0.))
+    {
+      fprintf(stderr, "ERROR: LU Solve singular matrix\n");
+      fprintf(stderr, "LU Solving failed with A[%d x %d]", M, N);
+      return -1;
+    }
+
+    ipiv[i] = p_i;
+
+    if (i != p_i)
+      dswap_6(N, &TIX(A, LDA, i, 0), LDA, &TIX(A, LDA, p_i, 0), LDA);
+
+    // Scale vector
+    m_0 = 1 / TIX(A, LDA, i, i);
+    m_0p = _mm256_set1_pd(m_0);
+    for (j = i + 1; j <= M - 4; j += 4)
+    {
+      _mm256_storeu_pd(&TIX(A, LDA, j, i),
+                       _mm256_mul_pd(m_0p, _mm256_loadu_pd(&TIX(A, LDA, j, i))));
+    }
+    for (; j < M; ++j)
+      TIX(A, LDA, j, i) = m_0 * TIX(A, LDA, j, i);
+
+    // Rank 1 update, the next column also yields its pivot
+    for (k = i + 1; k < N; ++k)
+    {
+      j = dgetf2_7_update_amax(M, i, k, A, LDA);
+      if (k == i + 1)
+        p_i = j;
+    }
+  }
+
+  return 0;
+}
+
+int dgetf2_7(int M, int N, double *A, int LDA, int *ipiv, double *work)
+{
+  int retcode, k;
+  const int N1 = MIN(M, N) / 2, N2 = N - N1;
+
+  if (MIN(M, N) <= DGETF2_RECURSIVE_MIN)
+    return dgetf2_7_base(M, N, A, LDA, ipiv);
+
+  // [A11; A21] = P1 * [L11; L21] * U11
+  retcode = dgetf2_7(M, N1, A, LDA, ipiv, work);
+  if (retcode != 0)
+    return retcode;
+
+  // Apply interchanges to [A12; A22]
+  dlaswp_6(N2, &TIX(A, LDA, 0, N1), LDA, 0, N1, ipiv, 1);
+
+  // A12 := L11^-1 * A12
+  dtrsm_L_7(N1, N2, A, LDA, &TIX(A, LDA, 0, N1), LDA, work);
+
+  // A22 := A22 - L21 * A12
+  dgemm_6(M - N1, N2, N1, -1.,       //
+          &TIX(A, LDA, N1, 0), LDA,  //
+          &TIX(A, LDA, 0, N1), LDA,  //
+          1.,                        //
+          &TIX(A, LDA, N1, N1), LDA, //
+          work                       //
+  );
+
+  // A22 = P2 * L22 * U22
+  retcode = dgetf2_7(M - N1, N2, &TIX(A, LDA, N1, N1), LDA, ipiv + N1, work);
+  if (retcode != 0)
+    return retcode;
+
+  for (k = N1; k < MIN(M, N); ++k)
+    ipiv[k] += N1;
+
+  // Apply interchanges to [A11; A21]
+  dlaswp_6(N1, A, LDA, N1, MIN(M, N), ipiv, 1);
+
+  return 0;
+}
@@ -18,3 +18,16 @@ int dgetf2_2(int M, int N, double *A, int LDA, int *ipiv);
 
 int dgetf2_5(int M, int N, double *A, int LDA, int *ipiv);
 int dgetf2_6(int M, int N, double *A, int LDA, int *ipiv);
+
+// Widest panel factored by the unblocked kernel of dgetf2_7
+#ifndef DGETF2_RECURSIVE_MIN
+#define DGETF2_RECURSIVE_MIN 8
+#endif
+
+/** @brief Recursive dgetf2 (Toledo, Gustavson): the left half of the
+ *         columns is factored, the right half is updated with dtrsm_L_7
+ *         and dgemm_6 and factored in turn.
+ *
+ * @param work Packing workspace of dgemm_6, see dgemm_alloc_work.
+ */
+int dgetf2_7(int M, int N, double *A, int LDA, int *ipiv, double *work);
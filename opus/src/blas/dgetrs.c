@@ -102,3 +102,15 @@ int dgetrs_6(int N, double *A, int *ipiv, double *b)
 #endif
   return 0;
 }
+
+int dgetrs_7(int N, int NRHS, double *A, int LDA, int *ipiv, double *B,
+             int LDB, double *work)
+{
+  // Swap pivot rows in B
+  dlaswp_6(NRHS, B, LDB, 0, N, ipiv, 1);
+  // Forward substitution
+  dtrsm_L_7(N, NRHS, A, LDA, B, LDB, work);
+  // Backward substitution
+  dtrsm_U_7(N, NRHS, A, LDA, B, LDB, work);
+  return 0;
+}
@@ -17,3 +17,12 @@ int dgetrs_1(int N, double *A, int *ipiv, double *b);
 int dgetrs_2(int N, double *A, int *ipiv, double *b);
 int dgetrs_5(int N, double *A, int *ipiv, double *b);
 int dgetrs_6(int N, double *A, int *ipiv, double *b);
+
+/** @brief dgetrs_6 for the NRHS right hand sides of the N x NRHS matrix B
+ *         (transposed layout, leading dimension LDB), with the blocked
+ *         dtrsm_L_7 / dtrsm_U_7 and A of leading dimension LDA.
+ *
+ * @param work Packing workspace of dgemm_6, see dgemm_alloc_work.
+ */
+int dgetrs_7(int N, int NRHS, double *A, int LDA, int *ipiv, double *B,
+             int LDB, double *work);
@@ -0,0 +1,36 @@
+#include <math.h>
+
+#include "../helpers.h"
+#include "dlarft.h"
+
+void dlarft_6(int M, int K, double *V, int LDV, double *tau, double *T,
+              int LDT)
+{
+  int i, l, r;
+  double z;
+
+  for (i = 0; i < K; ++i)
+  {
+    // T(0:i, i) := V(:, 0:i)^T * v_i, v_i(i) = 1 and v_i(0:i) = 0
+    for (l = 0; l < i; ++l)
+    {
+      z = TIX(V, LDV, i, l);
+      for (r = i + 1; r < M; ++r)
+        z += TIX(V, LDV, r, l) * TIX(V, LDV, r, i);
+      TIX(T, LDT, l, i) = -tau[i] * z;
+    }
+
+    // T(0:i, i) := T(0:i, 0:i) * T(0:i, i), T upper triangular
+    for (l = 0; l < i; ++l)
+    {
+      z = 0.;
+      for (r = l; r < i; ++r)
+        z += TIX(T, LDT, l, r) * TIX(T, LDT, r, i);
+      TIX(T, LDT, l, i) = z;
+    }
+
+    TIX(T, LDT, i, i) = tau[i];
+    for (l = i + 1; l < K; ++l)
+      TIX(T, LDT, l, i) = 0.;
+  }
+}
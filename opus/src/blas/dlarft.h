@@ -0,0 +1,21 @@
+#pragma once
+
+#if 0
+// Equivalent to DLARFT (forward, columnwise).
+/** @brief Form the upper triangular factor T of the block reflector
+ *         H = H_0 * H_1 * ... * H_{K-1} = I - V * T * V^T.
+ *
+ * @param M The number of rows of V.
+ * @param K The number of reflectors.
+ * @param V Reflectors as returned by dgeqr2 (unit diagonal implicit).
+ * @param LDV The leading dimension of V.
+ * @param tau The K scalar factors of the reflectors.
+ * @param T Output K x K upper triangular matrix (transposed layout).
+ * @param LDT The leading dimension of T.
+ */
+void dlarft(int M, int K, double *V, int LDV, double *tau, double *T,
+            int LDT);
+#endif
+
+void dlarft_6(int M, int K, double *V, int LDV, double *tau, double *T,
+              int LDT);
@@ -0,0 +1,113 @@
+#include <immintrin.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "../helpers.h"
+#include "dgemm.h"
+#include "dpotrf.h"
+
+// Y := Y - s * X
+static inline void daxpy_neg_6(int M, double s, double *X, double *Y)
+{
+  int i = 0;
+  __m256d sp = _mm256_set1_pd(s);
+
+  for (; i <= M - 8; i += 8)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i + 0);
+    __m256d y4 = _mm256_loadu_pd(Y + i + 4);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i + 0), y0);
+    y4 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i + 4), y4);
+    _mm256_storeu_pd(Y + i + 0, y0);
+    _mm256_storeu_pd(Y + i + 4, y4);
+  }
+  for (; i <= M - 4; i += 4)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i), y0);
+    _mm256_storeu_pd(Y + i, y0);
+  }
+  for (; i < M; ++i)
+    Y[i] -= s * X[i];
+}
+
+/** @brief Unblocked right-looking Cholesky of the N x N diagonal block,
+ *         the M - N rows below it are solved against L^T on the way
+ *         (A21 := A21 * L11^-T).
+ */
+static int dpotf2_6(int M, int N, double *A, int LDA)
+{
+  int j, k;
+  double ajj, r;
+
+  for (j = 0; j < N; ++j)
+  {
+    ajj = TIX(A, LDA, j, j);
+    if (ajj <= 0.)
+    {
+      fprintf(stderr, "ERROR: Cholesky matrix is not positive definite\n");
+      return -1;
+    }
+
+    ajj = sqrt(ajj);
+    TIX(A, LDA, j, j) = ajj;
+    r = 1. / ajj;
+    for (k = j + 1; k < M; ++k)
+      TIX(A, LDA, k, j) *= r;
+
+    // A(k:M, k) -= A(k:M, j) * A(k, j), for k in j+1 : N
+    for (k = j + 1; k < N; ++k)
+      daxpy_neg_6(M - k, TIX(A, LDA, k, j), &TIX(A, LDA, k, j),
+                  &TIX(A, LDA, k, k));
+  }
+
+  return 0;
+}
+
+int dpotrf_6(int N, double *A, int LDA, double *W, double *work)
+{
+  const int NB = CHOL_BLOCK;
+  int j, jb, jj, kb, c, ret;
+
+  for (j = 0; j < N; j += NB)
+  {
+    jb = MIN(NB, N - j);
+
+    // Factor the panel A(j:N, j:j+jb)
+    ret = dpotf2_6(N - j, jb, &TIX(A, LDA, j, j), LDA);
+    if (ret != 0)
+      return ret;
+
+    if (j + jb == N)
+      break;
+
+    // A22 -= L21 * L21^T, lower triangle only
+
+    // W := L21^T (jb x N)
+    for (jj = j + jb; jj < N; ++jj)
+      for (c = 0; c < jb; ++c)
+        TIX(W, NB, c, jj) = TIX(A, LDA, jj, j + c);
+
+    for (jj = j + jb; jj < N; jj += NB)
+    {
+      kb = MIN(NB, N - jj);
+
+      // Diagonal block
+      for (int k = jj; k < jj + kb; ++k)
+        for (c = 0; c < jb; ++c)
+          daxpy_neg_6(jj + kb - k, TIX(W, NB, c, k), &TIX(A, LDA, k, j + c),
+                      &TIX(A, LDA, k, k));
+
+      // Block below the diagonal
+      if (jj + kb < N)
+        dgemm_5(N - jj - kb, kb, jb, -1.,      //
+                &TIX(A, LDA, jj + kb, j), LDA, //
+                &TIX(W, NB, 0, jj), NB,        //
+                1.,                            //
+                &TIX(A, LDA, jj + kb, jj), LDA, //
+                work);
+    }
+  }
+
+  return 0;
+}
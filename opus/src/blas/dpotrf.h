@@ -0,0 +1,25 @@
+#pragma once
+
+// Number of columns factored per panel, the workspace needs
+// CHOL_BLOCK x N doubles.
+#ifndef CHOL_BLOCK
+#define CHOL_BLOCK 64
+#endif
+
+#if 0
+// Equivalent to DPOTRF (lower).
+/** @brief Blocked Cholesky factorization A = L * L^T of a symmetric
+ *         positive definite matrix. Only the lower triangle of A is
+ *         referenced and overwritten with L.
+ *
+ * @param N The number of rows and columns of A.
+ * @param A Real valued matrix (transposed layout).
+ * @param LDA The leading dimension of A.
+ * @param W Workspace of CHOL_BLOCK * N doubles.
+ * @param work dgemm workspace.
+ * @return 0 on success, <0 if A is not positive definite.
+ */
+int dpotrf(int N, double *A, int LDA, double *W, double *work);
+#endif
+
+int dpotrf_6(int N, double *A, int LDA, double *W, double *work);
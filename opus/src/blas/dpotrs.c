@@ -0,0 +1,31 @@
+#include <immintrin.h>
+#include <math.h>
+
+#include "../helpers.h"
+#include "dpotrs.h"
+
+int dpotrs_6(int N, double *A, int LDA, double *b)
+{
+  int i, k;
+  double bk;
+
+  // Forward substitution with L, column oriented
+  for (k = 0; k < N; ++k)
+  {
+    bk = b[k] / TIX(A, LDA, k, k);
+    b[k] = bk;
+    for (i = k + 1; i < N; ++i)
+      b[i] -= TIX(A, LDA, i, k) * bk;
+  }
+
+  // Backward substitution with L^T, row oriented over the columns of L
+  for (k = N - 1; k >= 0; --k)
+  {
+    bk = b[k];
+    for (i = k + 1; i < N; ++i)
+      bk -= TIX(A, LDA, i, k) * b[i];
+    b[k] = bk / TIX(A, LDA, k, k);
+  }
+
+  return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#if 0
+// Equivalent to DPOTRS (lower).
+/** @brief Solves system of linear equations A * x = b with A = L * L^T
+ *         factored by dpotrf. After exit b is overwritten with x.
+ *
+ * @param N Number of rows and columns in A.
+ * @param A The Cholesky factor L in the lower triangle.
+ * @param LDA The leading dimension of A.
+ * @param b Real valued vector with N elements.
+ */
+int dpotrs(int N, double *A, int LDA, double *b);
+#endif
+
+int dpotrs_6(int N, double *A, int LDA, double *b);
@@ -0,0 +1,259 @@
+#include <immintrin.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "../helpers.h"
+#include "dgemm.h"
+#include "dsytrf.h"
+#include "idamax.h"
+
+// (1 + sqrt(17)) / 8, bounds the element growth of Bunch-Kaufman pivoting
+#define BK_ALPHA 0.6403882032022076
+
+// Y := Y - s * X
+static inline void daxpy_neg_6(int M, double s, double *X, double *Y)
+{
+  int i = 0;
+  __m256d sp = _mm256_set1_pd(s);
+
+  for (; i <= M - 8; i += 8)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i + 0);
+    __m256d y4 = _mm256_loadu_pd(Y + i + 4);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i + 0), y0);
+    y4 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i + 4), y4);
+    _mm256_storeu_pd(Y + i + 0, y0);
+    _mm256_storeu_pd(Y + i + 4, y4);
+  }
+  for (; i <= M - 4; i += 4)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i), y0);
+    _mm256_storeu_pd(Y + i, y0);
+  }
+  for (; i < M; ++i)
+    Y[i] -= s * X[i];
+}
+
+static inline void dswap_rows(int N, double *A, int LDA, int r1, int r2)
+{
+  double t;
+  for (int c = 0; c < N; ++c)
+  {
+    t = TIX(A, LDA, r1, c);
+    TIX(A, LDA, r1, c) = TIX(A, LDA, r2, c);
+    TIX(A, LDA, r2, c) = t;
+  }
+}
+
+/** @brief Factor (at most) NB columns of A starting at column j0, left
+ *         looking inside the panel, then update the trailing matrix with
+ *         a rank-kb update of its lower triangle.
+ *
+ *  W (N x NB, leading dimension N) receives the updated panel columns
+ *  L * D, Wt (NB x N) its transpose for the trailing dgemm.
+ *
+ *  @return The number of factored columns kb, < 0 if A is singular.
+ */
+static int dlasyf_6(int N, int j0, int NB, double *A, int LDA, int *ipiv,
+                    double *W, double *Wt, double *work)
+{
+  const int LDW = N;
+  const int last_panel = (N - j0 <= NB);
+
+  int i, j, jj, c, k, kw, kk, kp, kb, jb, imax, jmax, kstep;
+  double absakk, colmax, rowmax, r1, d11, d21, d22, t;
+
+  k = j0;
+
+  // Leave room for a 2x2 pivot at the end of the panel, unless it is the
+  // last one.
+  while (k < N && (last_panel || k - j0 < NB - 1))
+  {
+    kw = k - j0;
+
+    // W(k:N, kw) := A(k:N, k) - A(k:N, j0:k) * W(k, 0:kw)^T
+    for (i = k; i < N; ++i)
+      TIX(W, LDW, i, kw) = TIX(A, LDA, i, k);
+    for (c = 0; c < kw; ++c)
+      daxpy_neg_6(N - k, TIX(W, LDW, k, c), &TIX(A, LDA, k, j0 + c),
+                  &TIX(W, LDW, k, kw));
+
+    kstep = 1;
+    absakk = fabs(TIX(W, LDW, k, kw));
+
+    if (k < N - 1)
+    {
+      imax = k + 1 + idamax_2(N - k - 1, &TIX(W, LDW, k + 1, kw), 1);
+      colmax = fabs(TIX(W, LDW, imax, kw));
+    }
+    else
+    {
+      imax = k;
+      colmax = 0.;
+    }
+
+    if (APPROX_EQUAL(MAX(absakk, colmax), 0.))
+    {
+      fprintf(stderr, "ERROR: LDLT singular matrix at column %d\n", k);
+      return -1;
+    }
+
+    if (absakk >= BK_ALPHA * colmax)
+    {
+      kp = k;
+    }
+    else
+    {
+      // W(k:N, kw + 1) := column imax of the updated trailing matrix
+      for (i = k; i < imax; ++i)
+        TIX(W, LDW, i, kw + 1) = TIX(A, LDA, imax, i);
+      for (i = imax; i < N; ++i)
+        TIX(W, LDW, i, kw + 1) = TIX(A, LDA, i, imax);
+      for (c = 0; c < kw; ++c)
+        daxpy_neg_6(N - k, TIX(W, LDW, imax, c), &TIX(A, LDA, k, j0 + c),
+                    &TIX(W, LDW, k, kw + 1));
+
+      // largest off-diagonal element in row / column imax
+      jmax = k + idamax_2(imax - k, &TIX(W, LDW, k, kw + 1), 1);
+      rowmax = fabs(TIX(W, LDW, jmax, kw + 1));
+      if (imax < N - 1)
+      {
+        jmax = imax + 1 + idamax_2(N - imax - 1, &TIX(W, LDW, imax + 1, kw + 1),
+                                   1);
+        rowmax = MAX(rowmax, fabs(TIX(W, LDW, jmax, kw + 1)));
+      }
+
+      if (absakk >= BK_ALPHA * colmax * (colmax / rowmax))
+      {
+        kp = k;
+      }
+      else if (fabs(TIX(W, LDW, imax, kw + 1)) >= BK_ALPHA * rowmax)
+      {
+        // 1x1 pivot on imax, the updated column is in W(:, kw + 1)
+        kp = imax;
+        for (i = k; i < N; ++i)
+          TIX(W, LDW, i, kw) = TIX(W, LDW, i, kw + 1);
+      }
+      else
+      {
+        kp = imax;
+        kstep = 2;
+      }
+    }
+
+    kk = k + kstep - 1;
+
+    if (kp != kk)
+    {
+      // Move the non-updated column kk to column kp, the updated column kp
+      // is already in W.
+      TIX(A, LDA, kp, kp) = TIX(A, LDA, kk, kk);
+      for (i = kk + 1; i < kp; ++i)
+        TIX(A, LDA, kp, i) = TIX(A, LDA, i, kk);
+      for (i = kp + 1; i < N; ++i)
+        TIX(A, LDA, i, kp) = TIX(A, LDA, i, kk);
+
+      // Interchange rows kk and kp in all factored columns of A (standard
+      // form, including the panels before j0) and of W.
+      dswap_rows(kk, A, LDA, kk, kp);
+      dswap_rows(kk - j0 + 1, W, LDW, kk, kp);
+    }
+
+    if (kstep == 1)
+    {
+      // L(k+1:N, k) := W(k+1:N, kw) / D(k, k)
+      TIX(A, LDA, k, k) = TIX(W, LDW, k, kw);
+      r1 = 1. / TIX(A, LDA, k, k);
+      for (i = k + 1; i < N; ++i)
+        TIX(A, LDA, i, k) = r1 * TIX(W, LDW, i, kw);
+    }
+    else
+    {
+      // [L(:, k) L(:, k+1)] := [W(:, kw) W(:, kw+1)] * D(k:k+2, k:k+2)^-1
+      if (k < N - 2)
+      {
+        d21 = TIX(W, LDW, k + 1, kw);
+        d11 = TIX(W, LDW, k + 1, kw + 1) / d21;
+        d22 = TIX(W, LDW, k, kw) / d21;
+        t = 1. / (d11 * d22 - 1.);
+        d21 = t / d21;
+
+        for (j = k + 2; j < N; ++j)
+        {
+          TIX(A, LDA, j, k) =
+              d21 * (d11 * TIX(W, LDW, j, kw) - TIX(W, LDW, j, kw + 1));
+          TIX(A, LDA, j, k + 1) =
+              d21 * (d22 * TIX(W, LDW, j, kw + 1) - TIX(W, LDW, j, kw));
+        }
+      }
+
+      TIX(A, LDA, k, k) = TIX(W, LDW, k, kw);
+      TIX(A, LDA, k + 1, k) = TIX(W, LDW, k + 1, kw);
+      TIX(A, LDA, k + 1, k + 1) = TIX(W, LDW, k + 1, kw + 1);
+    }
+
+    if (kstep == 1)
+    {
+      ipiv[k] = kp;
+    }
+    else
+    {
+      ipiv[k] = -1 - kp;
+      ipiv[k + 1] = -1 - kp;
+    }
+
+    k += kstep;
+  }
+
+  kb = k - j0;
+
+  if (k == N)
+    return kb;
+
+  // A(k:N, k:N) -= L(k:N, j0:k) * W(k:N, 0:kb)^T, lower triangle only
+
+  for (jj = k; jj < N; ++jj)
+    for (c = 0; c < kb; ++c)
+      TIX(Wt, NB, c, jj) = TIX(W, LDW, jj, c);
+
+  for (j = k; j < N; j += NB)
+  {
+    jb = MIN(NB, N - j);
+
+    // Diagonal block
+    for (jj = j; jj < j + jb; ++jj)
+      for (c = 0; c < kb; ++c)
+        daxpy_neg_6(j + jb - jj, TIX(Wt, NB, c, jj), &TIX(A, LDA, jj, j0 + c),
+                    &TIX(A, LDA, jj, jj));
+
+    // Block below the diagonal
+    if (j + jb < N)
+      dgemm_5(N - j - jb, jb, kb, -1.,       //
+              &TIX(A, LDA, j + jb, j0), LDA, //
+              &TIX(Wt, NB, 0, j), NB,        //
+              1.,                            //
+              &TIX(A, LDA, j + jb, j), LDA,  //
+              work);
+  }
+
+  return kb;
+}
+
+int dsytrf_6(int N, int K0, double *A, int LDA, int *ipiv, double *W,
+             double *work)
+{
+  const int NB = LDLT_BLOCK;
+
+  double *Wt = W + (size_t)N * NB;
+  int j, kb;
+
+  for (j = K0; j < N; j += kb)
+  {
+    kb = dlasyf_6(N, j, NB, A, LDA, ipiv, W, Wt, work);
+    if (kb < 0)
+      return kb;
+  }
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Number of columns factored per panel, the workspace W needs N x LDLT_BLOCK
+// doubles for the panel and as many for its transpose.
+#ifndef LDLT_BLOCK
+#define LDLT_BLOCK 64
+#endif
+
+#if 0
+// Equivalent to DSYTRF (lower) with the interchanges in standard form.
+/** @brief Factor the symmetric indefinite matrix A = P^T * L * D * L^T * P
+ *         using the Bunch-Kaufman diagonal pivoting method. Only the lower
+ *         triangle of A is referenced and overwritten with D and the
+ *         unit lower triangular L (the diagonal of L is not stored, the
+ *         subdiagonal of a 2x2 block of D is stored in place of L).
+ *
+ * @param N The number of rows and columns of A.
+ * @param K0 Columns 0 : K0 are already factored and A(K0:N, K0:N) holds the
+ *           Schur complement of the factored part. 0 for a full factor.
+ * @param A Real valued symmetric matrix (transposed layout).
+ * @param LDA The leading dimension of A.
+ * @param ipiv Pivot indices. ipiv[k] >= 0 : 1x1 block, rows k and ipiv[k]
+ *             were interchanged. ipiv[k] = ipiv[k + 1] = -1 - p : 2x2 block,
+ *             rows k + 1 and p were interchanged.
+ * @param W Workspace of 2 * N * LDLT_BLOCK doubles.
+ * @param work dgemm workspace.
+ * @return 0 on success, <0 if A is singular.
+ */
+int dsytrf(int N, int K0, double *A, int LDA, int *ipiv, double *W,
+           double *work);
+#endif
+
+int dsytrf_6(int N, int K0, double *A, int LDA, int *ipiv, double *W,
+             double *work);
@@ -0,0 +1,126 @@
+#include <immintrin.h>
+#include <math.h>
+
+#include "../helpers.h"
+#include "dsytrs.h"
+
+static inline void swapd(double *b, int i, int j)
+{
+  double t = b[i];
+  b[i] = b[j];
+  b[j] = t;
+}
+
+// Sum of X[i] * Y[i]
+static inline double ddot_6(int M, double *X, double *Y)
+{
+  int i = 0;
+  double s;
+  __m256d s0 = _mm256_setzero_pd(), s4 = _mm256_setzero_pd();
+  double acc[4] __attribute__((aligned(32)));
+
+  for (; i <= M - 8; i += 8)
+  {
+    s0 = _mm256_fmadd_pd(_mm256_loadu_pd(X + i + 0),
+                         _mm256_loadu_pd(Y + i + 0), s0);
+    s4 = _mm256_fmadd_pd(_mm256_loadu_pd(X + i + 4),
+                         _mm256_loadu_pd(Y + i + 4), s4);
+  }
+  _mm256_store_pd(acc, _mm256_add_pd(s0, s4));
+  s = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+  for (; i < M; ++i)
+    s += X[i] * Y[i];
+  return s;
+}
+
+int dsytrs_6(int N, double *A, int LDA, int *ipiv, double *b)
+{
+  int i, k, kp;
+  double bk, bk1, akm1k, akm1, ak, denom;
+
+  // b := P * b
+  for (k = 0; k < N;)
+  {
+    if (ipiv[k] >= 0)
+    {
+      if (ipiv[k] != k)
+        swapd(b, k, ipiv[k]);
+      k += 1;
+    }
+    else
+    {
+      kp = -1 - ipiv[k];
+      if (kp != k + 1)
+        swapd(b, k + 1, kp);
+      k += 2;
+    }
+  }
+
+  // Forward substitution with L, then D^-1
+  for (k = 0; k < N;)
+  {
+    if (ipiv[k] >= 0)
+    {
+      bk = b[k];
+      for (i = k + 1; i < N; ++i)
+        b[i] -= TIX(A, LDA, i, k) * bk;
+      b[k] = bk / TIX(A, LDA, k, k);
+      k += 1;
+    }
+    else
+    {
+      bk = b[k];
+      bk1 = b[k + 1];
+      for (i = k + 2; i < N; ++i)
+        b[i] -= TIX(A, LDA, i, k) * bk + TIX(A, LDA, i, k + 1) * bk1;
+
+      akm1k = TIX(A, LDA, k + 1, k);
+      akm1 = TIX(A, LDA, k, k) / akm1k;
+      ak = TIX(A, LDA, k + 1, k + 1) / akm1k;
+      denom = akm1 * ak - 1.;
+      bk = bk / akm1k;
+      bk1 = bk1 / akm1k;
+      b[k] = (ak * bk - bk1) / denom;
+      b[k + 1] = (akm1 * bk1 - bk) / denom;
+      k += 2;
+    }
+  }
+
+  // Backward substitution with L^T
+  for (k = N - 1; k >= 0;)
+  {
+    if (ipiv[k] >= 0)
+    {
+      b[k] -= ddot_6(N - k - 1, &TIX(A, LDA, k + 1, k), b + k + 1);
+      k -= 1;
+    }
+    else
+    {
+      // 2x2 block (k - 1, k)
+      b[k] -= ddot_6(N - k - 1, &TIX(A, LDA, k + 1, k), b + k + 1);
+      b[k - 1] -= ddot_6(N - k - 1, &TIX(A, LDA, k + 1, k - 1), b + k + 1);
+      k -= 2;
+    }
+  }
+
+  // x := P^T * x
+  for (k = N - 1; k >= 0;)
+  {
+    if (ipiv[k] >= 0)
+    {
+      if (ipiv[k] != k)
+        swapd(b, k, ipiv[k]);
+      k -= 1;
+    }
+    else
+    {
+      kp = -1 - ipiv[k];
+      if (kp != k)
+        swapd(b, k, kp);
+      k -= 2;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#if 0
+// Equivalent to DSYTRS (lower).
+/** @brief Solves system of linear equations A * x = b.
+ *         After exit b is overwritten with solution vector x.
+ *
+ * @param N Number of rows and columns in A.
+ * @param A Real valued NxN matrix A which has been factored by dsytrf.
+ * @param LDA The leading dimension of A.
+ * @param ipiv Pivot indices returned by dsytrf.
+ * @param b Real valued vector with N elements.
+ */
+int dsytrs(int N, double *A, int LDA, int *ipiv, double *b);
+#endif
+
+int dsytrs_6(int N, double *A, int LDA, int *ipiv, double *b);
@@ -1,7 +1,9 @@
 #include <assert.h>
+#include <immintrin.h>
 #include <math.h>
 
 #include "../helpers.h"
+#include "dgemm.h"
 #include "dtrsm.h"
 
 // ------------------------
@@ -141,3 +143,220 @@ void dtrsm_U_6(int M, int N, double *A, int LDA, double *B, int LDB)
             TIX(B, LDB, i, j) - TIX(B, LDB, k, j) * TIX(A, LDA, i, k);
     }
 }
+
+// ---------------------------------
+// Right Upper Triangular DTRSM_RU
+// ---------------------------------
+
+// Solves X * A = B, A is a upper / right / non-unit / *transposed* matrix
+// and B is M x N. Columns of B are contiguous, so the innermost loop
+// streams a whole column of B for each entry of A.
+void dtrsm_RU_6(int M, int N, double *A, int LDA, double *B, int LDB)
+{
+  int i, j, k;
+  double a_kj, r_jj;
+
+  for (j = 0; j < N; ++j)
+  {
+    for (k = 0; k < j; ++k)
+    {
+      a_kj = TIX(A, LDA, k, j);
+      for (i = 0; i < M; ++i)
+        TIX(B, LDB, i, j) = TIX(B, LDB, i, j) - TIX(B, LDB, i, k) * a_kj;
+    }
+
+    r_jj = 1. / TIX(A, LDA, j, j);
+    for (i = 0; i < M; ++i)
+      TIX(B, LDB, i, j) = TIX(B, LDB, i, j) * r_jj;
+  }
+}
+
+// ---------------------------
+// Blocked DTRSM_L / DTRSM_U
+// ---------------------------
+
+// b_c[i] -= l[i] * x_c for the rows i0 <= i < i1 of 4 columns of B
+#define AXPY_4_7(l, i0, i1)                                                    \
+  for (i = (i0); i + 4 <= (i1); i += 4)                                        \
+  {                                                                            \
+    l_i = _mm256_loadu_pd((l) + i);                                            \
+    _mm256_storeu_pd(b0 + i,                                                   \
+                     _mm256_fnmadd_pd(l_i, x0, _mm256_loadu_pd(b0 + i)));      \
+    _mm256_storeu_pd(b1 + i,                                                   \
+                     _mm256_fnmadd_pd(l_i, x1, _mm256_loadu_pd(b1 + i)));      \
+    _mm256_storeu_pd(b2 + i,                                                   \
+                     _mm256_fnmadd_pd(l_i, x2, _mm256_loadu_pd(b2 + i)));      \
+    _mm256_storeu_pd(b3 + i,                                                   \
+                     _mm256_fnmadd_pd(l_i, x3, _mm256_loadu_pd(b3 + i)));      \
+  }                                                                            \
+  for (; i < (i1); ++i)                                                        \
+  {                                                                            \
+    b0[i] -= (l)[i] * b0[k];                                                   \
+    b1[i] -= (l)[i] * b1[k];                                                   \
+    b2[i] -= (l)[i] * b2[k];                                                   \
+    b3[i] -= (l)[i] * b3[k];                                                   \
+  }
+
+// b[i] -= l[i] * x for the rows i0 <= i < i1 of one column of B
+#define AXPY_1_7(l, i0, i1)                                                    \
+  for (i = (i0); i + 4 <= (i1); i += 4)                                        \
+    _mm256_storeu_pd(b0 + i, _mm256_fnmadd_pd(_mm256_loadu_pd((l) + i), x0,    \
+                                              _mm256_loadu_pd(b0 + i)));       \
+  for (; i < (i1); ++i)                                                        \
+    b0[i] -= (l)[i] * b0[k];
+
+// Forward substitution with the M x M unit lower diagonal block A
+static void dtrsm_L_diag_7(int M, int N, double *A, int LDA, double *B,
+                           int LDB)
+{
+  int i, j, k;
+  double *b0, *b1, *b2, *b3;
+  __m256d x0, x1, x2, x3, l_i;
+
+  for (j = 0; j + 4 <= N; j += 4)
+  {
+    b0 = B + j * LDB, b1 = b0 + LDB, b2 = b1 + LDB, b3 = b2 + LDB;
+    for (k = 0; k < M; ++k)
+    {
+      x0 = _mm256_broadcast_sd(b0 + k);
+      x1 = _mm256_broadcast_sd(b1 + k);
+      x2 = _mm256_broadcast_sd(b2 + k);
+      x3 = _mm256_broadcast_sd(b3 + k);
+      AXPY_4_7(A + k * LDA, k + 1, M);
+    }
+  }
+
+  for (; j < N; ++j)
+  {
+    b0 = B + j * LDB;
+    for (k = 0; k < M; ++k)
+    {
+      x0 = _mm256_broadcast_sd(b0 + k);
+      AXPY_1_7(A + k * LDA, k + 1, M);
+    }
+  }
+}
+
+// Backward substitution with the M x M non-unit upper diagonal block A
+static void dtrsm_U_diag_7(int M, int N, double *A, int LDA, double *B,
+                           int LDB)
+{
+  int i, j, k;
+  double *b0, *b1, *b2, *b3;
+  __m256d x0, x1, x2, x3, l_i;
+
+  for (j = 0; j + 4 <= N; j += 4)
+  {
+    b0 = B + j * LDB, b1 = b0 + LDB, b2 = b1 + LDB, b3 = b2 + LDB;
+    for (k = M - 1; k >= 0; --k)
+    {
+      b0[k] /= TIX(A, LDA, k, k);
+      b1[k] /= TIX(A, LDA, k, k);
+      b2[k] /= TIX(A, LDA, k, k);
+      b3[k] /= TIX(A, LDA, k, k);
+      x0 = _mm256_broadcast_sd(b0 + k);
+      x1 = _mm256_broadcast_sd(b1 + k);
+      x2 = _mm256_broadcast_sd(b2 + k);
+      x3 = _mm256_broadcast_sd(b3 + k);
+      AXPY_4_7(A + k * LDA, 0, k);
+    }
+  }
+
+  for (; j < N; ++j)
+  {
+    b0 = B + j * LDB;
+    for (k = M - 1; k >= 0; --k)
+    {
+      b0[k] /= TIX(A, LDA, k, k);
+      x0 = _mm256_broadcast_sd(b0 + k);
+      AXPY_1_7(A + k * LDA, 0, k);
+    }
+  }
+}
+
+// C -= A * X for the M x K block A and the K x N block X. Fewer than 4
+// columns are not worth packing, their rows are updated 4 columns of A at
+// a time.
+static void dtrsm_update_7(int M, int N, int K, double *A, int LDA,
+                           double *X, int LDX, double *C, int LDC,
+                           double *work)
+{
+  int i, j, k;
+  double *c, *x, *a0, *a1, *a2, *a3;
+  __m256d x0, x1, x2, x3, c_i;
+
+  if (3 < N)
+  {
+    dgemm_6(M, N, K, -1., A, LDA, X, LDX, 1., C, LDC, work);
+    return;
+  }
+
+  for (j = 0; j < N; ++j)
+  {
+    c = C + j * LDC, x = X + j * LDX;
+    for (k = 0; k + 4 <= K; k += 4)
+    {
+      a0 = A + k * LDA, a1 = a0 + LDA, a2 = a1 + LDA, a3 = a2 + LDA;
+      x0 = _mm256_broadcast_sd(x + k + 0);
+      x1 = _mm256_broadcast_sd(x + k + 1);
+      x2 = _mm256_broadcast_sd(x + k + 2);
+      x3 = _mm256_broadcast_sd(x + k + 3);
+      for (i = 0; i + 4 <= M; i += 4)
+      {
+        c_i = _mm256_loadu_pd(c + i);
+        c_i = _mm256_fnmadd_pd(_mm256_loadu_pd(a0 + i), x0, c_i);
+        c_i = _mm256_fnmadd_pd(_mm256_loadu_pd(a1 + i), x1, c_i);
+        c_i = _mm256_fnmadd_pd(_mm256_loadu_pd(a2 + i), x2, c_i);
+        c_i = _mm256_fnmadd_pd(_mm256_loadu_pd(a3 + i), x3, c_i);
+        _mm256_storeu_pd(c + i, c_i);
+      }
+      for (; i < M; ++i)
+        c[i] -= a0[i] * x[k] + a1[i] * x[k + 1] + a2[i] * x[k + 2] +
+                a3[i] * x[k + 3];
+    }
+    for (; k < K; ++k)
+    {
+      a0 = A + k * LDA;
+      for (i = 0; i < M; ++i)
+        c[i] -= a0[i] * x[k];
+    }
+  }
+}
+
+void dtrsm_L_7(int M, int N, double *A, int LDA, double *B, int LDB,
+               double *work)
+{
+  int r0, nb;
+
+  for (r0 = 0; r0 < M; r0 += nb)
+  {
+    nb = MIN(M - r0, DTRSM_BLOCK);
+    dtrsm_L_diag_7(nb, N, &TIX(A, LDA, r0, r0), LDA, &TIX(B, LDB, r0, 0),
+                   LDB);
+
+    // B[r0 + nb : M, :] -= A[r0 + nb : M, r0 : r0 + nb] * X[r0 : r0 + nb, :]
+    if (r0 + nb < M)
+      dtrsm_update_7(M - r0 - nb, N, nb, &TIX(A, LDA, r0 + nb, r0), LDA,
+                     &TIX(B, LDB, r0, 0), LDB, &TIX(B, LDB, r0 + nb, 0), LDB,
+                     work);
+  }
+}
+
+void dtrsm_U_7(int M, int N, double *A, int LDA, double *B, int LDB,
+               double *work)
+{
+  int r0, r1;
+
+  // from the bottom, the top block takes the remainder
+  for (r1 = M; 0 < r1; r1 = r0)
+  {
+    r0 = MAX(0, r1 - DTRSM_BLOCK);
+    dtrsm_U_diag_7(r1 - r0, N, &TIX(A, LDA, r0, r0), LDA,
+                   &TIX(B, LDB, r0, 0), LDB);
+
+    // B[0 : r0, :] -= A[0 : r0, r0 : r1] * X[r0 : r1, :]
+    if (0 < r0)
+      dtrsm_update_7(r0, N, r1 - r0, &TIX(A, LDA, 0, r0), LDA,
+                     &TIX(B, LDB, r0, 0), LDB, B, LDB, work);
+  }
+}
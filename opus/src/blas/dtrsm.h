@@ -32,3 +32,21 @@ void dtrsm_U_1(int M, int N, double *A, int LDA, double *B, int LDB);
 void dtrsm_U_2(int M, int N, double *A, int LDA, double *B, int LDB);
 void dtrsm_U_5(int M, int N, double *A, int LDA, double *B, int LDB);
 void dtrsm_U_6(int M, int N, double *A, int LDA, double *B, int LDB);
+
+void dtrsm_RU_6(int M, int N, double *A, int LDA, double *B, int LDB);
+
+// Rows of the diagonal blocks of dtrsm_L_7 and dtrsm_U_7
+#ifndef DTRSM_BLOCK
+#define DTRSM_BLOCK 64
+#endif
+
+/** @brief Blocked dtrsm_L_6 / dtrsm_U_6: the diagonal blocks of A are
+ *         solved for 4 columns of B at a time, the rest of B is updated by
+ *         dgemm_6.
+ *
+ * @param work Packing workspace of dgemm_6, see dgemm_alloc_work.
+ */
+void dtrsm_L_7(int M, int N, double *A, int LDA, double *B, int LDB,
+               double *work);
+void dtrsm_U_7(int M, int N, double *A, int LDA, double *B, int LDB,
+               double *work);
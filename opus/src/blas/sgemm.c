@@ -0,0 +1,233 @@
+#include "sgemm.h"
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "../helpers.h"
+
+// Same blocking as dgemm, a float block is half the size.
+#if !defined(M_BLOCK) || !defined(N_BLOCK) || !defined(K_BLOCK)
+#error Missing definitions for M,N,K block sizes
+#endif
+
+float *sgemm_alloc_work()
+{
+  return (float *)aligned_alloc(
+      4096, (SGEMM_WORK_SIZE * sizeof(float) + 4095) & -4096);
+}
+
+// C(i : i + 8, j) -= c
+#define STORE_8_6(c, i, j)                                                     \
+  _mm256_storeu_ps(&TIX(C, LDC, i, j),                                         \
+                   _mm256_sub_ps(_mm256_loadu_ps(&TIX(C, LDC, i, j)), c));
+
+// NOTE sgemm_6 assumes a TRANSPOSED memory layout, A and B are packed
+static void sgemm_6_mini(const int M, const int N, const int K,
+                         float *restrict A, float *restrict B,
+                         float *restrict C, const int LDC)
+{
+  int i, j, k;
+  float *abuff, *bbuff;
+
+  const int M16_MOD = M & -16, M8_MOD = M & -8, N4_MOD = N & -4;
+
+  __m256 a_i0, a_i8, b_j0, b_j1, b_j2, b_j3;
+  __m256 c_i0_j0, c_i0_j1, c_i0_j2, c_i0_j3, //
+      c_i8_j0, c_i8_j1, c_i8_j2, c_i8_j3;
+  float s_a, s_c0, s_c1, s_c2, s_c3;
+
+  for (j = 0; j < N4_MOD; j += 4)
+  {
+    for (i = 0; i < M16_MOD; i += 16)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      c_i0_j0 = c_i0_j1 = c_i0_j2 = c_i0_j3 = _mm256_setzero_ps();
+      c_i8_j0 = c_i8_j1 = c_i8_j2 = c_i8_j3 = _mm256_setzero_ps();
+      for (k = 0; k < K; ++k, abuff += 16, bbuff += 4)
+      {
+        a_i0 = _mm256_load_ps(abuff + 0);
+        a_i8 = _mm256_load_ps(abuff + 8);
+        b_j0 = _mm256_broadcast_ss(bbuff + 0);
+        b_j1 = _mm256_broadcast_ss(bbuff + 1);
+        c_i0_j0 = _mm256_fmadd_ps(a_i0, b_j0, c_i0_j0);
+        c_i8_j0 = _mm256_fmadd_ps(a_i8, b_j0, c_i8_j0);
+        c_i0_j1 = _mm256_fmadd_ps(a_i0, b_j1, c_i0_j1);
+        c_i8_j1 = _mm256_fmadd_ps(a_i8, b_j1, c_i8_j1);
+        b_j2 = _mm256_broadcast_ss(bbuff + 2);
+        b_j3 = _mm256_broadcast_ss(bbuff + 3);
+        c_i0_j2 = _mm256_fmadd_ps(a_i0, b_j2, c_i0_j2);
+        c_i8_j2 = _mm256_fmadd_ps(a_i8, b_j2, c_i8_j2);
+        c_i0_j3 = _mm256_fmadd_ps(a_i0, b_j3, c_i0_j3);
+        c_i8_j3 = _mm256_fmadd_ps(a_i8, b_j3, c_i8_j3);
+      }
+      STORE_8_6(c_i0_j0, i + 0, j + 0);
+      STORE_8_6(c_i8_j0, i + 8, j + 0);
+      STORE_8_6(c_i0_j1, i + 0, j + 1);
+      STORE_8_6(c_i8_j1, i + 8, j + 1);
+      STORE_8_6(c_i0_j2, i + 0, j + 2);
+      STORE_8_6(c_i8_j2, i + 8, j + 2);
+      STORE_8_6(c_i0_j3, i + 0, j + 3);
+      STORE_8_6(c_i8_j3, i + 8, j + 3);
+    }
+    for (; i < M8_MOD; i += 8)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      c_i0_j0 = c_i0_j1 = c_i0_j2 = c_i0_j3 = _mm256_setzero_ps();
+      for (k = 0; k < K; ++k, abuff += 8, bbuff += 4)
+      {
+        a_i0 = _mm256_load_ps(abuff);
+        c_i0_j0 = _mm256_fmadd_ps(a_i0, _mm256_broadcast_ss(bbuff + 0),
+                                  c_i0_j0);
+        c_i0_j1 = _mm256_fmadd_ps(a_i0, _mm256_broadcast_ss(bbuff + 1),
+                                  c_i0_j1);
+        c_i0_j2 = _mm256_fmadd_ps(a_i0, _mm256_broadcast_ss(bbuff + 2),
+                                  c_i0_j2);
+        c_i0_j3 = _mm256_fmadd_ps(a_i0, _mm256_broadcast_ss(bbuff + 3),
+                                  c_i0_j3);
+      }
+      STORE_8_6(c_i0_j0, i, j + 0);
+      STORE_8_6(c_i0_j1, i, j + 1);
+      STORE_8_6(c_i0_j2, i, j + 2);
+      STORE_8_6(c_i0_j3, i, j + 3);
+    }
+    for (; i < M; ++i)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      s_c0 = s_c1 = s_c2 = s_c3 = 0.f;
+      for (k = 0; k < K; ++k, ++abuff, bbuff += 4)
+      {
+        s_a = *abuff;
+        s_c0 += s_a * bbuff[0];
+        s_c1 += s_a * bbuff[1];
+        s_c2 += s_a * bbuff[2];
+        s_c3 += s_a * bbuff[3];
+      }
+      TIX(C, LDC, i, j + 0) -= s_c0;
+      TIX(C, LDC, i, j + 1) -= s_c1;
+      TIX(C, LDC, i, j + 2) -= s_c2;
+      TIX(C, LDC, i, j + 3) -= s_c3;
+    }
+  }
+
+  for (; j < N; ++j)
+  {
+    for (i = 0; i < M16_MOD; i += 16)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      c_i0_j0 = c_i8_j0 = _mm256_setzero_ps();
+      for (k = 0; k < K; ++k, abuff += 16, ++bbuff)
+      {
+        b_j0 = _mm256_broadcast_ss(bbuff);
+        c_i0_j0 = _mm256_fmadd_ps(_mm256_load_ps(abuff + 0), b_j0, c_i0_j0);
+        c_i8_j0 = _mm256_fmadd_ps(_mm256_load_ps(abuff + 8), b_j0, c_i8_j0);
+      }
+      STORE_8_6(c_i0_j0, i + 0, j);
+      STORE_8_6(c_i8_j0, i + 8, j);
+    }
+    for (; i < M8_MOD; i += 8)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      c_i0_j0 = _mm256_setzero_ps();
+      for (k = 0; k < K; ++k, abuff += 8, ++bbuff)
+        c_i0_j0 = _mm256_fmadd_ps(_mm256_load_ps(abuff),
+                                  _mm256_broadcast_ss(bbuff), c_i0_j0);
+      STORE_8_6(c_i0_j0, i, j);
+    }
+    for (; i < M; ++i)
+    {
+      abuff = A + i * K, bbuff = B + j * K;
+      s_c0 = 0.f;
+      for (k = 0; k < K; ++k)
+        s_c0 += abuff[k] * bbuff[k];
+      TIX(C, LDC, i, j) -= s_c0;
+    }
+  }
+}
+
+// packing A with 16,8,1 blocks
+static void pack_a_6(float *dst, float *src, int LDA, int M, int N)
+{
+  int i, j;
+  float *s0;
+
+  for (i = 0; i < M - 15; i += 16)
+  {
+    s0 = src + i;
+    for (j = 0; j < N; ++j, dst += 16, s0 += LDA)
+    {
+      _mm256_store_ps(dst + 0, _mm256_loadu_ps(s0 + 0));
+      _mm256_store_ps(dst + 8, _mm256_loadu_ps(s0 + 8));
+    }
+  }
+
+  for (; i < M - 7; i += 8)
+  {
+    s0 = src + i;
+    for (j = 0; j < N; ++j, dst += 8, s0 += LDA)
+      _mm256_store_ps(dst, _mm256_loadu_ps(s0));
+  }
+
+  for (; i < M; ++i)
+  {
+    s0 = src + i;
+    for (j = 0; j < N; ++j, s0 += LDA)
+      *dst++ = *s0;
+  }
+}
+
+// packing B in 4,1 blocks
+static void pack_b_6(float *dst, float *src, int LDB, int M, int N)
+{
+  int i, j;
+  float *s0, *s1, *s2, *s3;
+
+  for (j = 0; j < N - 3; j += 4)
+  {
+    s0 = src + j * LDB;
+    s1 = s0 + LDB;
+    s2 = s1 + LDB;
+    s3 = s2 + LDB;
+    for (i = 0; i < M; ++i)
+    {
+      *dst++ = *s0++;
+      *dst++ = *s1++;
+      *dst++ = *s2++;
+      *dst++ = *s3++;
+    }
+  }
+
+  for (; j < N; ++j)
+  {
+    s0 = src + j * LDB;
+    for (i = 0; i < M; ++i)
+      *dst++ = *s0++;
+  }
+}
+
+void sgemm_6(int M, int N, int K, float *restrict A, int LDA,
+             float *restrict B, int LDB, float *restrict C, int LDC,
+             float *work)
+{
+  float *AL = work;
+  float *BL = work + SGEMM_WORK_B;
+
+  int i, j, k, //
+      d_i, d_j, d_k;
+
+  // A[M, K] B[K, N] C[M, N]
+  for (j = 0; j < N; j += d_j)
+  {
+    d_j = MIN(N - j, N_BLOCK);
+    for (k = 0; k < K; k += d_k)
+    {
+      d_k = MIN(K - k, K_BLOCK);
+      pack_b_6(BL, &TIX(B, LDB, k, j), LDB, d_k, d_j);
+      for (i = 0; i < M; i += d_i)
+      {
+        d_i = MIN(M - i, M_BLOCK);
+        pack_a_6(AL, &TIX(A, LDA, i, k), LDA, d_i, d_k);
+        sgemm_6_mini(d_i, d_j, d_k, AL, BL, &TIX(C, LDC, i, j), LDC);
+      }
+    }
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#if 0
+// Single precision counterpart of dgemm_5 / dgemm_6, used by the mixed
+// precision LU. Twice the SIMD width and half the bandwidth of the double
+// version.
+/** @brief compute C := C - A * B
+ *
+ * @param M Number of rows (height) of A and C.
+ * @param N Number of cols (width) of B and C.
+ * @param K Number of cols (width) of A and rows (height) of B.
+ * @param A Real valued MxK matrix A (transposed layout).
+ * @param LDA Leading dimension of A.
+ * @param B Real valued KxN matrix B (transposed layout).
+ * @param LDB Leading dimension of B.
+ * @param C Real valued MxN matrix C (transposed layout).
+ * @param Leading dimension of C.
+ * @param work Packing workspace of SGEMM_WORK_SIZE floats, from
+ *             sgemm_alloc_work.
+ */
+void sgemm(int M, int N, int K, float *A, int LDA, float *B, int LDB,
+           float *C, int LDC, float *work);
+#endif
+
+// Same layout as the dgemm workspace
+#define SGEMM_WORK_B ((M_BLOCK * K_BLOCK + 1023) & -1024)
+#define SGEMM_WORK_SIZE (SGEMM_WORK_B + K_BLOCK * N_BLOCK)
+
+// Release with free
+float *sgemm_alloc_work();
+
+void sgemm_6(int M, int N, int K, float *A, int LDA, float *B, int LDB,
+             float *C, int LDC, float *work);
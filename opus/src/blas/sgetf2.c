@@ -0,0 +1,80 @@
+#include "sgetf2.h"
+
+#include <float.h>
+#include <immintrin.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "../helpers.h"
+
+int sgetf2_6(int M, int N, float *A, int LDA, int *ipiv)
+{
+  int i, j, k, p_i;
+  float p_v, m_0, A_i_k, tmp;
+
+  __m256 m_0p, A_i_kp;
+
+  // Quick return
+  if (!M || !N)
+    return 0;
+
+  for (i = 0; i < MIN(M, N); ++i)
+  {
+    // Pivot search
+    p_i = i;
+    p_v = fabsf(TIX(A, LDA, i, i));
+    for (j = i + 1; j < M; ++j)
+      if (p_v < fabsf(TIX(A, LDA, j, i)))
+      {
+        p_i = j;
+        p_v = fabsf(TIX(A, LDA, j, i));
+      }
+
+    // Not only singular matrices, also anything that did not survive the
+    // conversion to float ends up here.
+    if (!(0.f < p_v && p_v <= FLT_MAX))
+    {
+      return -1;
+    }
+
+    ipiv[i] = p_i;
+
+    if (i != p_i)
+    {
+      for (k = 0; k < N; ++k)
+      {
+        tmp = TIX(A, LDA, i, k);
+        TIX(A, LDA, i, k) = TIX(A, LDA, p_i, k);
+        TIX(A, LDA, p_i, k) = tmp;
+      }
+    }
+
+    // BLAS 1 Scale vector ---
+    m_0 = 1.f / TIX(A, LDA, i, i);
+    m_0p = _mm256_set1_ps(m_0);
+    for (j = i + 1; j <= M - 8; j += 8)
+      _mm256_storeu_ps(&TIX(A, LDA, j, i),
+                       _mm256_mul_ps(m_0p, _mm256_loadu_ps(&TIX(A, LDA, j, i))));
+    for (; j < M; ++j)
+      TIX(A, LDA, j, i) = m_0 * TIX(A, LDA, j, i);
+    // --- BLAS 1 Scale Vector
+
+    // BLAS 2 Rank 1 update ---
+    for (k = i + 1; k < N; ++k)
+    {
+      A_i_k = TIX(A, LDA, i, k);
+      A_i_kp = _mm256_set1_ps(A_i_k);
+
+      for (j = i + 1; j <= M - 8; j += 8)
+        _mm256_storeu_ps(
+            &TIX(A, LDA, j, k),
+            _mm256_fnmadd_ps(_mm256_loadu_ps(&TIX(A, LDA, j, i)), A_i_kp,
+                             _mm256_loadu_ps(&TIX(A, LDA, j, k))));
+      for (; j < M; ++j)
+        TIX(A, LDA, j, k) = TIX(A, LDA, j, k) - TIX(A, LDA, j, i) * A_i_k;
+    }
+    // --- BLAS 2 Rank 1 update
+  }
+
+  return 0;
+}
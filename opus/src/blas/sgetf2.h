@@ -0,0 +1,16 @@
+#pragma once
+
+#if 0
+// Single precision counterpart of dgetf2, used by the mixed precision LU.
+/** @brief Factor A = P * L * U in place using BLAS1 / BLAS2 functions
+ *
+ * @param M The number of rows (height) of A.
+ * @param N The number of columns (width) of A.
+ * @param A Real valued matrix in which to factor [L\U].
+ * @param LDA The leading dimension of the matrix in memory A.
+ * @param ipiv Pivot indices for A.
+ */
+int sgetf2(int M, int N, float *A, int LDA, int *ipiv);
+#endif
+
+int sgetf2_6(int M, int N, float *A, int LDA, int *ipiv);
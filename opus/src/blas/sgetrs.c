@@ -0,0 +1,17 @@
+#include "sgetrs.h"
+
+#include "slaswp.h"
+#include "strsm.h"
+
+int sgetrs_6(int N, float *A, int LDA, int *ipiv, float *b)
+{
+  // A now contains L (below diagonal)
+  //                U (above diagonal)
+  // Swap pivot rows in b
+  slaswp_6(1, b, 1, 0, N, ipiv);
+  // Forward substitution
+  strsm_L_6(N, 1, A, LDA, b, 1);
+  // Backward substitution
+  strsm_U_6(N, 1, A, LDA, b, 1);
+  return 0;
+}
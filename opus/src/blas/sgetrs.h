@@ -0,0 +1,17 @@
+#pragma once
+
+#if 0
+// Single precision counterpart of dgetrs (no-transpose).
+/** @brief Solves system of linear equations A * x = b.
+ *         After exit b is overwritten with solution vector x.
+ *
+ * @param N Number of rows and columns in A.
+ * @param A Real valued NxN matrix A which has been factored into [L\U].
+ * @param LDA Leading dimension of A.
+ * @param ipiv Pivot indices used when factoring A.
+ * @param b Real valued vector with N elements.
+ */
+int sgetrs(int N, float *A, int LDA, int *ipiv, float *b);
+#endif
+
+int sgetrs_6(int N, float *A, int LDA, int *ipiv, float *b);
@@ -0,0 +1,23 @@
+#include "slaswp.h"
+
+#include "../helpers.h"
+
+void slaswp_6(int N, float *A, int LDA, int k1, int k2, int *ipiv)
+{
+  int i, j, k, p_i;
+  float tmp;
+
+  // Swap in blocks of 32 columns so the rows k1 : k2 stay in cache
+  for (j = 0; j < N; j += 32)
+    for (i = k1; i < k2; ++i)
+    {
+      p_i = ipiv[i];
+      if (p_i != i)
+        for (k = j; k < MIN(N, j + 32); ++k)
+        {
+          tmp = TIX(A, LDA, i, k);
+          TIX(A, LDA, i, k) = TIX(A, LDA, p_i, k);
+          TIX(A, LDA, p_i, k) = tmp;
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#if 0
+// Single precision counterpart of dlaswp (incx = 1).
+/** @brief Perform a series of row interchanges, one for each row
+ *         k1 - k2 of A.
+ *
+ * @param N The number of column in MxN matrix A.
+ * @param A MxN real valued matrix (transposed layout).
+ * @param LDA Leading dimension of A.
+ * @param k1 The first element of ipiv to interchange rows.
+ * @param k2 (k2 - k1) elements of ipiv to do row interchanges.
+ * @param ipiv The array of vector pivot indices such that i <-> ipiv[i].
+ */
+void slaswp(int N, float *A, int LDA, int k1, int k2, int *ipiv);
+#endif
+
+void slaswp_6(int N, float *A, int LDA, int k1, int k2, int *ipiv);
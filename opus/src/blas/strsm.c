@@ -0,0 +1,32 @@
+#include "strsm.h"
+
+#include "../helpers.h"
+
+void strsm_L_6(int M, int N, float *A, int LDA, float *B, int LDB)
+{
+  int i, j, k;
+  float b_kj;
+
+  for (j = 0; j < N; ++j)
+    for (k = 0; k < M; ++k)
+    {
+      b_kj = TIX(B, LDB, k, j);
+      for (i = k + 1; i < M; ++i)
+        TIX(B, LDB, i, j) = TIX(B, LDB, i, j) - b_kj * TIX(A, LDA, i, k);
+    }
+}
+
+void strsm_U_6(int M, int N, float *A, int LDA, float *B, int LDB)
+{
+  int i, j, k;
+  float b_kj;
+
+  for (j = 0; j < N; ++j)
+    for (k = M - 1; k >= 0; --k)
+    {
+      b_kj = TIX(B, LDB, k, j) / TIX(A, LDA, k, k);
+      TIX(B, LDB, k, j) = b_kj;
+      for (i = 0; i < k; ++i)
+        TIX(B, LDB, i, j) = TIX(B, LDB, i, j) - b_kj * TIX(A, LDA, i, k);
+    }
+}
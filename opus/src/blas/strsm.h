@@ -0,0 +1,28 @@
+#pragma once
+
+#if 0
+// Single precision counterparts of dtrsm_L / dtrsm_U, used by the mixed
+// precision LU.
+/** @brief Solves matrix equation A * X = B
+ *         A is assumed to be Non-transposed (L)ower
+ *         triangular with a unit diagonal
+ *         After exit, the matrix B is overwritten with
+ *         the solution matrix X.
+ *
+ *  @param M Number of rows (height) of B.
+ *  @param N Number of cols (width) of B.
+ *  @param A Real valued matrix A.
+ *  @param LDA Leading dimension of A.
+ *  @param B Real valued matrix B.
+ *  @param LDB Leading dimension of B.
+ */
+void strsm_L(int M, int N, float *A, int LDA, float *B, int LDB);
+
+/** @brief equivalent to strsm_L except A is an (U)pper triangular matrix
+ *         with a *Non-unit* diagonal.
+ */
+void strsm_U(int M, int N, float *A, int LDA, float *B, int LDB);
+#endif
+
+void strsm_L_6(int M, int N, float *A, int LDA, float *B, int LDB);
+void strsm_U_6(int M, int N, float *A, int LDA, float *B, int LDB);
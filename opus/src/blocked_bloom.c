@@ -0,0 +1,286 @@
+#include "blocked_bloom.h"
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "murmurhash.h"
+
+#define BLOCKED_BLOOM_SEED 0x9747b28c
+#define BLOCKED_BLOOM_BLOCK_SIZE (BLOCKED_BLOOM_WORDS * sizeof(uint32_t))
+
+// odd multipliers, the first eight are the ones of Parquet
+static uint32_t const salts[BLOCKED_BLOOM_WORDS] = {
+    0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d, 0x705495c7, 0x2df1424b,
+    0x9efc4947, 0x5c6bfb31, 0x9e3779b9, 0x85ebca6b, 0xc2b2ae35, 0xcc9e2d51,
+    0x1b873593, 0x27d4eb2f, 0x165667b1, 0xd3a2646d};
+
+// False positive rate of a block holding lambda keys on average (Poisson)
+static double blocked_bloom_fpr(double lambda)
+{
+  double fpr = 0.;
+  double pmf = exp(-lambda);
+  double word_miss = 1. - 1. / 32;
+  double x_max = lambda + 10. * sqrt(lambda) + 20.;
+  for (int x = 0; x <= x_max; x++)
+  {
+    double fill = 1. - pow(word_miss, x);
+    fpr += pmf * pow(fill, BLOCKED_BLOOM_WORDS);
+    pmf *= lambda / (x + 1);
+  }
+  return fpr;
+}
+
+// Largest average number of keys per block with a false positive rate of
+// at most error
+static double blocked_bloom_keys_per_block(double error)
+{
+  double lo = 0., hi = 512.;
+  for (int it = 0; it < 50; it++)
+  {
+    double mid = (lo + hi) / 2;
+    if (blocked_bloom_fpr(mid) <= error)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static int blocked_bloom_add_stage(struct blocked_bloom *bloom,
+                                   size_t capacity, double error)
+{
+  double lambda = blocked_bloom_keys_per_block(error);
+  size_t n_blocks = 1;
+  while (n_blocks * lambda < capacity && n_blocks < ((size_t)1 << 32))
+    n_blocks *= 2;
+
+  struct blocked_bloom_stage *stage = &bloom->stages[bloom->n_stages];
+  stage->blocks = aligned_alloc(64, n_blocks * BLOCKED_BLOOM_BLOCK_SIZE);
+  if (!stage->blocks)
+    return 1;
+  memset(stage->blocks, 0, n_blocks * BLOCKED_BLOOM_BLOCK_SIZE);
+  stage->mask = n_blocks - 1;
+  stage->capacity = (size_t)(n_blocks * lambda);
+  if (stage->capacity == 0)
+    stage->capacity = 1;
+  stage->entries = 0;
+
+  bloom->n_stages++;
+  bloom->error = error;
+  return 0;
+}
+
+int blocked_bloom_init(struct blocked_bloom *bloom, size_t entries,
+                       double error)
+{
+  bloom->n_stages = 0;
+  if (error <= 0.)
+    return 1;
+
+  // the stages have errors error / 2, error / 4, ...
+  return blocked_bloom_add_stage(bloom, entries, error / 2);
+}
+
+void blocked_bloom_free(struct blocked_bloom *bloom)
+{
+  for (int s = 0; s < bloom->n_stages; s++)
+    free(bloom->stages[s].blocks);
+  bloom->n_stages = 0;
+}
+
+/*
+ * Hashing
+ */
+
+static inline __m256i rotl_8(__m256i x, int r)
+{
+  return _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r));
+}
+
+// murmurhash of 8 keys of words 32 bit words, stored contiguously
+static void blocked_bloom_hash_8(uint32_t const *keys, size_t words,
+                                 uint32_t *out)
+{
+  __m256i c1 = _mm256_set1_epi32(0xcc9e2d51);
+  __m256i c2 = _mm256_set1_epi32(0x1b873593);
+  __m256i m = _mm256_set1_epi32(5);
+  __m256i n = _mm256_set1_epi32(0xe6546b64);
+
+  __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                   _mm256_set1_epi32(words));
+  __m256i h = _mm256_set1_epi32(BLOCKED_BLOOM_SEED);
+
+  for (size_t w = 0; w < words; w++)
+  {
+    __m256i k = _mm256_i32gather_epi32((int const *)(keys + w), idx, 4);
+    k = _mm256_mullo_epi32(k, c1);
+    k = rotl_8(k, 15);
+    k = _mm256_mullo_epi32(k, c2);
+
+    h = _mm256_xor_si256(h, k);
+    h = rotl_8(h, 13);
+    h = _mm256_add_epi32(_mm256_mullo_epi32(h, m), n);
+  }
+
+  h = _mm256_xor_si256(h, _mm256_set1_epi32(4 * words));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x85ebca6b));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0xc2b2ae35));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+
+  _mm256_storeu_si256((__m256i *)out, h);
+}
+
+void blocked_bloom_hash(void const *keys, size_t len, size_t n,
+                        uint32_t *hashes)
+{
+  char const *k = keys;
+  size_t i = 0;
+
+  if (len % 4 == 0)
+  {
+    for (; i + 8 <= n; i += 8)
+      blocked_bloom_hash_8((uint32_t const *)(k + i * len), len / 4,
+                           hashes + i);
+  }
+
+  for (; i < n; i++)
+    hashes[i] = murmurhash(k + i * len, len, BLOCKED_BLOOM_SEED);
+}
+
+/*
+ * Blocks
+ */
+
+// the block is picked from a remix of the hash, the bits from its products
+// with the salts
+static inline uint32_t blocked_bloom_block(uint32_t hash)
+{
+  hash ^= hash >> 16;
+  hash *= 0x7feb352d;
+  hash ^= hash >> 15;
+  hash *= 0x846ca68b;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+static inline void blocked_bloom_masks(uint32_t hash, __m256i *lo,
+                                       __m256i *hi)
+{
+  __m256i h = _mm256_set1_epi32(hash);
+  __m256i one = _mm256_set1_epi32(1);
+  __m256i salt_lo = _mm256_loadu_si256((__m256i const *)salts);
+  __m256i salt_hi = _mm256_loadu_si256((__m256i const *)(salts + 8));
+
+  __m256i bit_lo = _mm256_srli_epi32(_mm256_mullo_epi32(h, salt_lo), 27);
+  __m256i bit_hi = _mm256_srli_epi32(_mm256_mullo_epi32(h, salt_hi), 27);
+  *lo = _mm256_sllv_epi32(one, bit_lo);
+  *hi = _mm256_sllv_epi32(one, bit_hi);
+}
+
+static inline uint32_t *blocked_bloom_stage_block(
+    struct blocked_bloom_stage const *stage, uint32_t hash)
+{
+  return stage->blocks +
+         (size_t)(blocked_bloom_block(hash) & stage->mask) *
+             BLOCKED_BLOOM_WORDS;
+}
+
+static inline int blocked_bloom_check_hash(struct blocked_bloom const *bloom,
+                                           uint32_t hash)
+{
+  __m256i lo, hi;
+  blocked_bloom_masks(hash, &lo, &hi);
+
+  for (int s = 0; s < bloom->n_stages; s++)
+  {
+    uint32_t const *block = blocked_bloom_stage_block(&bloom->stages[s], hash);
+    __m256i b_lo = _mm256_load_si256((__m256i const *)block);
+    __m256i b_hi = _mm256_load_si256((__m256i const *)(block + 8));
+    // all the bits of the masks are set in the block
+    if (_mm256_testc_si256(b_lo, lo) && _mm256_testc_si256(b_hi, hi))
+      return 1;
+  }
+  return 0;
+}
+
+void blocked_bloom_prefetch(struct blocked_bloom const *bloom,
+                            uint32_t const *hashes, size_t n)
+{
+  for (int s = 0; s < bloom->n_stages; s++)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      _mm_prefetch(
+          (char const *)blocked_bloom_stage_block(&bloom->stages[s], hashes[i]),
+          _MM_HINT_T0);
+    }
+  }
+}
+
+int blocked_bloom_check_any(struct blocked_bloom const *bloom,
+                            uint32_t const *hashes, size_t n)
+{
+  blocked_bloom_prefetch(bloom, hashes, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (blocked_bloom_check_hash(bloom, hashes[i]))
+      return 1;
+  }
+  return 0;
+}
+
+void blocked_bloom_add_hash(struct blocked_bloom *bloom, uint32_t hash)
+{
+  struct blocked_bloom_stage *stage = &bloom->stages[bloom->n_stages - 1];
+
+  // full, open a stage twice as large with half the error rate (the last
+  // one keeps filling up if there is no room for one more)
+  if (stage->entries >= stage->capacity &&
+      bloom->n_stages < BLOCKED_BLOOM_MAX_STAGES &&
+      blocked_bloom_add_stage(bloom, 2 * stage->capacity, bloom->error / 2) ==
+          0)
+  {
+    stage = &bloom->stages[bloom->n_stages - 1];
+  }
+
+  __m256i lo, hi;
+  blocked_bloom_masks(hash, &lo, &hi);
+
+  uint32_t *block = blocked_bloom_stage_block(stage, hash);
+  __m256i *b_lo = (__m256i *)block;
+  __m256i *b_hi = (__m256i *)(block + 8);
+  _mm256_store_si256(b_lo, _mm256_or_si256(_mm256_load_si256(b_lo), lo));
+  _mm256_store_si256(b_hi, _mm256_or_si256(_mm256_load_si256(b_hi), hi));
+  stage->entries++;
+}
+
+int blocked_bloom_check(struct blocked_bloom const *bloom, void const *key,
+                        size_t len)
+{
+  return blocked_bloom_check_hash(
+      bloom, murmurhash((char const *)key, len, BLOCKED_BLOOM_SEED));
+}
+
+void blocked_bloom_add(struct blocked_bloom *bloom, void const *key,
+                       size_t len)
+{
+  blocked_bloom_add_hash(bloom,
+                         murmurhash((char const *)key, len, BLOCKED_BLOOM_SEED));
+}
+
+void blocked_bloom_print(struct blocked_bloom const *bloom)
+{
+  printf("blocked bloom at %p\n", (void const *)bloom);
+  for (int s = 0; s < bloom->n_stages; s++)
+  {
+    struct blocked_bloom_stage const *stage = &bloom->stages[s];
+    printf(" ->stage %d: blocks = %zu, capacity = %zu, entries = %zu\n", s,
+           (size_t)stage->mask + 1, stage->capacity, stage->entries);
+  }
+  printf(" ->error = %g\n", bloom->error);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Blocked bloom filter
+ *
+ * All the bits of a key are in one 64 byte block (a cache line) picked by
+ * its hash: a key sets one bit in each of the BLOCKED_BLOOM_WORDS 32 bit
+ * words of its block, bit (hash * salt_w) >> 27 of word w (a split block
+ * bloom filter, as in Parquet, over a whole line). A check is then one
+ * cache miss and two AVX2 compares, whatever the error rate.
+ *
+ * The filter grows as a scalable bloom filter (Almeida et al., "Scalable
+ * Bloom Filters", 2007): once a stage holds the number of keys it was sized
+ * for, a stage twice as large with half the error rate is added. Checks look
+ * in every stage and the false positive rate stays below the requested one.
+ */
+
+#define BLOCKED_BLOOM_WORDS 16
+#define BLOCKED_BLOOM_MAX_STAGES 32
+
+struct blocked_bloom_stage
+{
+  // 64 bytes aligned, BLOCKED_BLOOM_WORDS words per block
+  uint32_t *blocks;
+  // number of blocks - 1, a power of two - 1
+  uint32_t mask;
+  // keys it holds at its error rate
+  size_t capacity;
+  size_t entries;
+};
+
+struct blocked_bloom
+{
+  struct blocked_bloom_stage stages[BLOCKED_BLOOM_MAX_STAGES];
+  int n_stages;
+  // error rate of the last stage
+  double error;
+};
+
+// entries: the expected number of keys, the filter grows beyond
+// error: the false positive rate
+int blocked_bloom_init(struct blocked_bloom *bloom, size_t entries,
+                       double error);
+void blocked_bloom_free(struct blocked_bloom *bloom);
+
+/** @brief Hashes of the n keys of len bytes stored contiguously in keys
+ *
+ * The hash is the 32 bit murmurhash of the key. When len is a multiple of
+ * 4, eight keys are hashed at once in AVX2 lanes.
+ */
+void blocked_bloom_hash(void const *keys, size_t len, size_t n,
+                        uint32_t *hashes);
+
+// Whether one of the n keys may be in the filter. The blocks of all the keys
+// are prefetched before the first compare.
+int blocked_bloom_check_any(struct blocked_bloom const *bloom,
+                            uint32_t const *hashes, size_t n);
+void blocked_bloom_prefetch(struct blocked_bloom const *bloom,
+                            uint32_t const *hashes, size_t n);
+void blocked_bloom_add_hash(struct blocked_bloom *bloom, uint32_t hash);
+
+int blocked_bloom_check(struct blocked_bloom const *bloom, void const *key,
+                        size_t len);
+void blocked_bloom_add(struct blocked_bloom *bloom, void const *key,
+                       size_t len);
+
+void blocked_bloom_print(struct blocked_bloom const *bloom);
@@ -1,11 +1,14 @@
 #include "distincts.h"
 
+#include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <immintrin.h>
 
 #include "helpers.h"
+#include "steps/fit_surrogate.h"
 
 #if DISTINCTIVENESS_CHECK_TYPE == 0
 // Accept all
@@ -14,16 +17,62 @@
 #elif DISTINCTIVENESS_CHECK_TYPE == 2
 // Bloom filter
 #include "rounding_bloom.h"
+#elif DISTINCTIVENESS_CHECK_TYPE == 3
+// Grid hash
+#include "grid_hash.h"
 #endif
 
+/*
+ * x_distinct and everything sized by the number of distinct points grow
+ * geometrically, so the memory tracks the number of points actually kept
+ * rather than the worst case of time_max iterations.
+ */
+void reserve_distincts(struct pso_data_constant_inertia *pso, size_t n)
+{
+  if (n <= pso->x_distinct_cap)
+    return;
+
+  size_t cap = MAX(n, 2 * pso->x_distinct_cap);
+  size_t dim = pso->dimensions;
+
+  double *old_x_distinct = pso->x_distinct;
+  pso->x_distinct = realloc(pso->x_distinct, cap * dim * sizeof(double));
+  pso->x_distinct_eval = realloc(pso->x_distinct_eval, cap * sizeof(double));
+  pso->x_distinct_norm2 = realloc(pso->x_distinct_norm2, cap * sizeof(double));
+#if DISTINCTIVENESS_CHECK_TYPE == 1
+  pso->batch_dist2 = realloc(pso->batch_dist2,
+                             cap * pso->population_size * sizeof(double));
+#endif
+  // y_hat may be the local refinement point kept in x_distinct
+  if (old_x_distinct <= pso->y_hat &&
+      pso->y_hat < old_x_distinct + pso->x_distinct_s * dim)
+    pso->y_hat = pso->x_distinct + (pso->y_hat - old_x_distinct);
+
+  // the LU fits solve in place, lambda_p is then their right hand side
+  int lambda_p_in_ctx = pso->ctx.b && pso->lambda_p == pso->ctx.b;
+  fit_surrogate_reserve(&pso->ctx, cap, dim + 1);
+  if (lambda_p_in_ctx)
+    pso->lambda_p = pso->ctx.b;
+  else
+    pso->lambda_p = realloc(pso->lambda_p, (cap + dim + 1) * sizeof(double));
+
+  pso->x_distinct_cap = cap;
+}
+
 double *add_to_distincts_unconditionnaly(struct pso_data_constant_inertia *pso,
                                          double const *const x, double x_eval)
 {
+  reserve_distincts(pso, pso->x_distinct_s + 1);
   size_t dst = pso->x_distinct_s;
   // copy point and value to x_distinct
   memcpy(PSO_XD(pso, dst), x, pso->dimensions * sizeof(double));
   pso->x_distinct_eval[dst] = x_eval;
+  pso->x_distinct_norm2[dst] = norm2(pso->dimensions, x);
   pso->x_distinct_s++;
+  eval_cache_insert(pso, dst);
+#if DISTINCTIVENESS_CHECK_TYPE == 3
+  grid_hash_insert(&pso->grid, pso->x_distinct, dst);
+#endif
 
   return PSO_XD(pso, dst);
 }
@@ -42,9 +91,176 @@ int add_to_distincts_if_distinct(struct pso_data_constant_inertia *pso,
   }
 }
 
+// Distances of x to all of x_distinct, to row x_distinct_s of the phi cache
+static void phi_cache_row(struct pso_data_constant_inertia *pso,
+                          double const *const x)
+{
+  size_t x_distinct_s = pso->x_distinct_s;
+  double *chache_dest =
+      pso->ctx.phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
+
+  for (size_t k = 0; k < x_distinct_s; k++)
+  {
+    double d2 = dist2(pso->dimensions, x, PSO_XD(pso, k));
+    chache_dest[k] = sqrt(d2) * d2;
+  }
+}
+
+double *add_to_distincts_checked(struct pso_data_constant_inertia *pso,
+                                 double const *const x, double x_eval)
+{
+  reserve_distincts(pso, pso->x_distinct_s + 1);
+  if (CHECK_IF_DISTINCT_VERSION != check_if_distinct_0)
+    phi_cache_row(pso, x);
+  return add_to_distincts_unconditionnaly(pso, x, x_eval);
+}
+
+#if DISTINCTIVENESS_CHECK_TYPE == 1
+// Squared distances of x to u0 and u1, summed as in check_if_distinct_1_opt
+static inline __m128d dist2_pair(size_t dim, double const *u0_ptr,
+                                 double const *u1_ptr, double const *x_ptr)
+{
+  __m256d s0 = _mm256_set1_pd(0);
+  __m256d s1 = _mm256_set1_pd(0);
+
+  size_t i = 0;
+  for (; i + 3 < dim; i += 4)
+  {
+    __m256d u0 = _mm256_loadu_pd(u0_ptr + i);
+    __m256d u1 = _mm256_loadu_pd(u1_ptr + i);
+    __m256d x = _mm256_loadu_pd(x_ptr + i);
+
+    __m256d v0 = _mm256_sub_pd(u0, x);
+    __m256d v1 = _mm256_sub_pd(u1, x);
+    s0 = _mm256_fmadd_pd(v0, v0, s0);
+    s1 = _mm256_fmadd_pd(v1, v1, s1);
+  }
+
+  __m256d t1 = _mm256_hadd_pd(s0, s1);
+  __m128d tlow = _mm256_castpd256_pd128(t1);
+  __m128d thigh = _mm256_extractf128_pd(t1, 1);
+  __m128d d2 = _mm_add_pd(tlow, thigh);
+
+  for (; i < dim; i++)
+  {
+    __m128d uu = _mm_load1_pd(&u0_ptr[i]);
+    __m128d uv = _mm_loadh_pd(uu, &u1_ptr[i]);
+    __m128d xi = _mm_load1_pd(&x_ptr[i]);
+    __m128d diff = _mm_sub_pd(uv, xi);
+    d2 = _mm_fmadd_pd(diff, diff, d2);
+  }
+
+  return d2;
+}
+
+/*
+ * Squared distances of the n points of xs to the m first points of
+ * x_distinct, d2[i * m + k]. x_distinct is swept once, two points at a
+ * time against all of xs (which stays in L1).
+ */
+static void dist2_block(struct pso_data_constant_inertia const *pso,
+                        double const *const xs, size_t n, size_t m,
+                        double *d2)
+{
+  size_t dim = pso->dimensions;
+
+  size_t k = 0;
+  for (; k + 1 < m; k += 2)
+  {
+    double const *u0 = PSO_XD(pso, k);
+    double const *u1 = PSO_XD(pso, k + 1);
+    for (size_t i = 0; i < n; i++)
+      _mm_storeu_pd(d2 + i * m + k, dist2_pair(dim, u0, u1, xs + i * dim));
+  }
+
+  for (; k < m; k++)
+  {
+    for (size_t i = 0; i < n; i++)
+      d2[i * m + k] = dist2(dim, xs + i * dim, PSO_XD(pso, k));
+  }
+}
+#endif
+
+void add_to_distincts_if_distinct_batch(struct pso_data_constant_inertia *pso,
+                                        double const *const xs,
+                                        double const *const x_evals, size_t n)
+{
+#if DISTINCTIVENESS_CHECK_TYPE == 1
+  size_t dim = pso->dimensions;
+  size_t m = pso->x_distinct_s;
+  // the rows check_if_distinct would have filled
+  int fill_cache = CHECK_IF_DISTINCT_VERSION != check_if_distinct_0;
+
+  // the population against the points already in x_distinct, in one sweep
+  dist2_block(pso, xs, n, m, pso->batch_dist2);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    double const *x = xs + i * dim;
+    double const *d2 = pso->batch_dist2 + i * m;
+
+    // rejected only if d2 < min_dist2, as in check_if_distinct
+    int distinct = 1;
+    for (size_t k = 0; k < m && distinct; k++)
+      distinct = !(d2[k] < pso->min_dist2);
+    if (!distinct)
+      continue;
+
+    // then against the points of the population added before it
+    size_t x_distinct_s = pso->x_distinct_s;
+    reserve_distincts(pso, x_distinct_s + 1);
+    double *chache_dest =
+        pso->ctx.phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
+    for (size_t k = m; k < x_distinct_s && distinct; k++)
+    {
+      double d2_k = dist2(dim, x, PSO_XD(pso, k));
+      if (fill_cache)
+        chache_dest[k] = sqrt(d2_k) * d2_k;
+      distinct = !(d2_k < pso->min_dist2);
+    }
+    if (!distinct)
+      continue;
+
+    if (fill_cache)
+    {
+      // reserve_distincts may have moved it
+      d2 = pso->batch_dist2 + i * m;
+      for (size_t k = 0; k < m; k++)
+        chache_dest[k] = sqrt(d2[k]) * d2[k];
+    }
+    add_to_distincts_unconditionnaly(pso, x, x_evals[i]);
+  }
+
+#elif DISTINCTIVENESS_CHECK_TYPE == 2
+  // all the bloom filter lookups at once, in order
+  size_t dim = pso->dimensions;
+  int *found = pso->distinct_found;
+  rounding_bloom_check_add_batch(pso->bloom, dim, xs, n, 1, found);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    if (found[i])
+      continue;
+
+    reserve_distincts(pso, pso->x_distinct_s + 1);
+    // the row check_if_distinct would have filled
+    if (CHECK_IF_DISTINCT_VERSION == check_if_distinct_3)
+      phi_cache_row(pso, xs + i * dim);
+    add_to_distincts_unconditionnaly(pso, xs + i * dim, x_evals[i]);
+  }
+
+#else
+  for (size_t i = 0; i < n; i++)
+    add_to_distincts_if_distinct(pso, xs + i * pso->dimensions, x_evals[i]);
+#endif
+}
+
 int check_if_distinct(struct pso_data_constant_inertia *pso,
                       double const *const x, int add_to_cache)
 {
+  // the distances to x go to row x_distinct_s of the phi cache
+  if (add_to_cache)
+    reserve_distincts(pso, pso->x_distinct_s + 1);
   return CHECK_IF_DISTINCT_VERSION(pso, x, add_to_cache);
 }
 
@@ -71,6 +287,9 @@ int check_if_distinct_0(struct pso_data_constant_inertia *pso,
   return !rounding_bloom_check_add(pso->bloom, pso->dimensions, x,
                                    add_to_cache);
 
+#elif DISTINCTIVENESS_CHECK_TYPE == 3
+  return !grid_hash_has_close(&pso->grid, pso->x_distinct, x);
+
 #endif
 }
 
@@ -81,9 +300,6 @@ int check_if_distinct_0(struct pso_data_constant_inertia *pso,
  * AND WITH THE NAIVE DISTANCE COMPUTATION
  */
 
-extern size_t fit_surrogate_max_N_phi;
-extern double *fit_surrogate_phi_cache;
-
 int check_if_distinct_1(struct pso_data_constant_inertia *pso,
                         double const *const x, int add_to_cache)
 {
@@ -91,7 +307,7 @@ int check_if_distinct_1(struct pso_data_constant_inertia *pso,
 
   size_t x_distinct_s = pso->x_distinct_s;
   double *chache_dest =
-      fit_surrogate_phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
+      pso->ctx.phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
 
   for (int i = 0; i < pso->x_distinct_s; i++)
   {
@@ -133,7 +349,7 @@ int check_if_distinct_1_opt(struct pso_data_constant_inertia *pso,
 
   size_t x_distinct_s = pso->x_distinct_s;
   double *chache_dest =
-      fit_surrogate_phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
+      pso->ctx.phi_cache + x_distinct_s * (x_distinct_s - 1) / 2;
 
   __m128d zero_128 = _mm_set1_pd(0.);
   __m128d min_dist_d2__128 = _mm_set1_pd(pso->min_dist2);
@@ -186,10 +402,10 @@ int check_if_distinct_1_opt(struct pso_data_constant_inertia *pso,
     {
       __m128d d = _mm_sqrt_pd(d2);
       __m128d d3 = _mm_mul_pd(d, d2);
-      _mm_store_pd(chache_dest + k, d3);
+      _mm_storeu_pd(chache_dest + k, d3);
     }
 
-    __m128d cmp = _mm_cmple_pd(d2, min_dist_d2__128);
+    __m128d cmp = _mm_cmplt_pd(d2, min_dist_d2__128);
     int far_enough = _mm_testz_pd(cmp, cmp);
 
     if (!far_enough)
@@ -229,4 +445,40 @@ int check_if_distinct_1_opt(struct pso_data_constant_inertia *pso,
       "check_if_distinct_1 only compatible with naive distance computations" &&
       false);
 #endif
-}
\ No newline at end of file
+}
+
+/*
+ * v3: only the points of the neighbouring grid cells (or of the same bloom
+ * filter buckets) are compared to x, the distances to all the others are
+ * computed for the cache of fit_surrogate version >= 6 once x is known to be
+ * distinct
+ */
+
+int check_if_distinct_3(struct pso_data_constant_inertia *pso,
+                        double const *const x, int add_to_cache)
+{
+#if DISTINCTIVENESS_CHECK_TYPE == 2 || DISTINCTIVENESS_CHECK_TYPE == 3
+
+#if DISTINCTIVENESS_CHECK_TYPE == 2
+  if (rounding_bloom_check_add(pso->bloom, pso->dimensions, x, add_to_cache))
+    return 0;
+#else
+  if (grid_hash_has_close(&pso->grid, pso->x_distinct, x))
+    return 0;
+#endif
+
+  if (add_to_cache)
+    phi_cache_row(pso, x);
+
+  // as in v1, the row is concretized when x is added to x_distinct
+  return 1;
+
+#else
+  (void)pso;
+  (void)x;
+  (void)add_to_cache;
+  assert("check_if_distinct_3 only compatible with the grid hash and the "
+         "bloom filter" &&
+         false);
+#endif
+}
@@ -3,17 +3,35 @@
 #include "pso.h"
 
 #ifndef CHECK_IF_DISTINCT_VERSION
+#if DISTINCTIVENESS_CHECK_TYPE == 2 || DISTINCTIVENESS_CHECK_TYPE == 3
+#define CHECK_IF_DISTINCT_VERSION check_if_distinct_3
+#else
 #define CHECK_IF_DISTINCT_VERSION check_if_distinct_1_opt
 #endif
+#endif
+
+// Make room for n points in x_distinct and the surrogate buffers
+void reserve_distincts(struct pso_data_constant_inertia *pso, size_t n);
 
 double *add_to_distincts_unconditionnaly(struct pso_data_constant_inertia *pso,
                                          double const *const x, double x_eval);
 
 int check_if_distinct(struct pso_data_constant_inertia *pso,
                       double const *const x, int add_to_cache);
+// Add x, already found distinct by check_if_distinct without add_to_cache,
+// to x_distinct. Its row of the phi cache is computed against the current
+// x_distinct, x is not checked (nor looked up in the bloom filter) again.
+double *add_to_distincts_checked(struct pso_data_constant_inertia *pso,
+                                 double const *const x, double x_eval);
 
 int add_to_distincts_if_distinct(struct pso_data_constant_inertia *pso,
                                  double const *const x, double x_eval);
+// add_to_distincts_if_distinct of the n <= population_size points of xs in
+// turn, with the distances to x_distinct (or the bloom filter lookups)
+// computed for all of them at once
+void add_to_distincts_if_distinct_batch(struct pso_data_constant_inertia *pso,
+                                        double const *const xs,
+                                        double const *const x_evals, size_t n);
 
 int check_if_distinct_0(struct pso_data_constant_inertia *pso,
                         double const *const x, int add_to_cache);
@@ -21,3 +39,5 @@ int check_if_distinct_1(struct pso_data_constant_inertia *pso,
                         double const *const x, int add_to_cache);
 int check_if_distinct_1_opt(struct pso_data_constant_inertia *pso,
                         double const *const x, int add_to_cache);
+int check_if_distinct_3(struct pso_data_constant_inertia *pso,
+                        double const *const x, int add_to_cache);
@@ -0,0 +1,82 @@
+#include "eval_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "murmurhash.h"
+#include "pso.h"
+
+void eval_cache_init(struct eval_cache *cache, size_t capacity,
+                     size_t max_batch)
+{
+  // at most half full
+  size_t n_slots = 16;
+  while (n_slots < 2 * capacity)
+    n_slots *= 2;
+
+  cache->slots = calloc(n_slots, sizeof(size_t));
+  cache->mask = n_slots - 1;
+  cache->miss = malloc(max_batch * sizeof(size_t));
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+void eval_cache_free(struct eval_cache *cache)
+{
+  free(cache->slots);
+  free(cache->miss);
+  cache->slots = NULL;
+  cache->miss = NULL;
+}
+
+static size_t eval_cache_slot(struct pso_data_constant_inertia const *pso,
+                              double const *x)
+{
+  return murmurhash((char const *)x, pso->dimensions * sizeof(double),
+                    0x9747b28c) &
+         pso->eval_cache.mask;
+}
+
+ssize_t eval_cache_find(struct pso_data_constant_inertia const *pso,
+                        double const *x)
+{
+  struct eval_cache const *cache = &pso->eval_cache;
+  size_t len = pso->dimensions * sizeof(double);
+
+  for (size_t s = eval_cache_slot(pso, x); cache->slots[s];
+       s = (s + 1) & cache->mask)
+  {
+    size_t idx = cache->slots[s] - 1;
+    if (memcmp(PSO_XD(pso, idx), x, len) == 0)
+      return idx;
+  }
+  return -1;
+}
+
+static void eval_cache_place(struct pso_data_constant_inertia *pso, size_t idx)
+{
+  struct eval_cache *cache = &pso->eval_cache;
+
+  size_t s = eval_cache_slot(pso, PSO_XD(pso, idx));
+  while (cache->slots[s])
+    s = (s + 1) & cache->mask;
+  cache->slots[s] = idx + 1;
+}
+
+void eval_cache_insert(struct pso_data_constant_inertia *pso, size_t idx)
+{
+  struct eval_cache *cache = &pso->eval_cache;
+
+  // keep it at most half full, rehash x_distinct[0 : idx] into twice as
+  // many slots
+  if (2 * (idx + 1) > cache->mask + 1)
+  {
+    size_t n_slots = 2 * (cache->mask + 1);
+    free(cache->slots);
+    cache->slots = calloc(n_slots, sizeof(size_t));
+    cache->mask = n_slots - 1;
+    for (size_t k = 0; k < idx; k++)
+      eval_cache_place(pso, k);
+  }
+  eval_cache_place(pso, idx);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+struct pso_data_constant_inertia;
+
+/*
+ * Exact match cache of the black box evaluations
+ *
+ * Every point of x_distinct is indexed by the bit pattern of its
+ * coordinates in an open addressing (linear probing) hash table, so that
+ * evaluating a point that was evaluated before returns the value stored in
+ * x_distinct_eval instead of calling f again. Points that were evaluated
+ * but not kept in x_distinct (too close to another one) are not cached.
+ */
+struct eval_cache
+{
+  // x_distinct index + 1 of the point hashed to each slot, 0 if empty
+  size_t *slots;
+  size_t mask;
+  // positions of the misses of the current batch
+  size_t *miss;
+  // evaluations served from the cache / handed to the black box
+  size_t hits;
+  size_t misses;
+};
+
+// capacity: the initial number of points in x_distinct, the table grows
+// with it.
+// max_batch: the maximum number of points of one pso_evaluate_batch.
+void eval_cache_init(struct eval_cache *cache, size_t capacity,
+                     size_t max_batch);
+void eval_cache_free(struct eval_cache *cache);
+
+// Index in x_distinct of a point with the same bits as x, -1 if none
+ssize_t eval_cache_find(struct pso_data_constant_inertia const *pso,
+                        double const *x);
+// Index the point x_distinct[idx]
+void eval_cache_insert(struct pso_data_constant_inertia *pso, size_t idx);
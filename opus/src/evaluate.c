@@ -0,0 +1,54 @@
+#include "evaluate.h"
+
+#include "threads.h"
+
+void evaluate_batch(blackbox_fun f, int dimensions, size_t n, double const *X,
+                    double *out)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)                                 \
+    num_threads(EVAL_THREADS ? EVAL_THREADS : omp_get_max_threads())
+#endif
+  for (long k = 0; k < (long)n; ++k)
+    out[k] = f(X + k * dimensions);
+}
+
+void pso_evaluate_batch(struct pso_data_constant_inertia *pso, size_t n,
+                        double const *X, double *out)
+{
+  struct eval_cache *cache = &pso->eval_cache;
+  blackbox_fun f = pso->f;
+  int dim = pso->dimensions;
+  size_t *miss = cache->miss;
+  size_t n_miss = 0;
+
+  for (size_t k = 0; k < n; ++k)
+  {
+    ssize_t idx = eval_cache_find(pso, X + k * dim);
+    if (idx < 0)
+      miss[n_miss++] = k;
+    else
+      out[k] = pso->x_distinct_eval[idx];
+  }
+  cache->hits += n - n_miss;
+  cache->misses += n_miss;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)                                 \
+    num_threads(EVAL_THREADS ? EVAL_THREADS : omp_get_max_threads())
+#endif
+  for (long m = 0; m < (long)n_miss; ++m)
+    out[miss[m]] = f(X + miss[m] * dim);
+}
+
+double pso_evaluate(struct pso_data_constant_inertia *pso, double const *x)
+{
+  ssize_t idx = eval_cache_find(pso, x);
+  if (0 <= idx)
+  {
+    pso->eval_cache.hits++;
+    return pso->x_distinct_eval[idx];
+  }
+  pso->eval_cache.misses++;
+  return pso->f(x);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "pso.h"
+
+// Threads evaluating the black box in evaluate_batch, 0 for all of
+// OMP_NUM_THREADS. Only used when built with WITH_OPENMP=1.
+#ifndef EVAL_THREADS
+#define EVAL_THREADS 0
+#endif
+
+/** @brief Evaluate the black box at n points.
+ *
+ * The points are handed out one at a time to EVAL_THREADS threads, so that
+ * slow and fast evaluations balance out, and f must be thread safe. out[k]
+ * is always f(X(k, :)), the results do not depend on the scheduling.
+ *
+ * @param f: The black box.
+ * @param dimensions: Length of a point.
+ * @param n: Number of points.
+ * @param X: The points, n x dimensions row by row.
+ * @param out: The n evaluations.
+ */
+void evaluate_batch(blackbox_fun f, int dimensions, size_t n, double const *X,
+                    double *out);
+
+/** @brief evaluate_batch of pso->f, with the points found in pso->eval_cache
+ *         taken from x_distinct_eval instead.
+ *
+ * n must not exceed the max_batch of the cache.
+ */
+void pso_evaluate_batch(struct pso_data_constant_inertia *pso, size_t n,
+                        double const *X, double *out);
+// pso->f(x) unless x is in pso->eval_cache
+double pso_evaluate(struct pso_data_constant_inertia *pso, double const *x);
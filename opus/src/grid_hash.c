@@ -0,0 +1,119 @@
+#include "grid_hash.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "helpers.h"
+#include "murmurhash.h"
+
+void grid_hash_init(struct grid_hash *grid, int dimensions, double min_dist,
+                    size_t capacity)
+{
+  // at most one point per two slots
+  size_t n_slots = 16;
+  while (n_slots < 2 * capacity)
+    n_slots *= 2;
+
+  grid->heads = calloc(n_slots, sizeof(size_t));
+  grid->mask = n_slots - 1;
+  grid->next = malloc(capacity * sizeof(size_t));
+  grid->next_cap = capacity;
+  grid->dims = MIN(dimensions, GRID_HASH_DIMS);
+  grid->dimensions = dimensions;
+  // with min_dist = 0 only equal points are close, any cell size will do
+  grid->inv_cell = min_dist > 0 ? 1. / min_dist : 1.;
+  grid->min_dist2 = min_dist * min_dist;
+}
+
+void grid_hash_free(struct grid_hash *grid)
+{
+  free(grid->heads);
+  free(grid->next);
+  grid->heads = NULL;
+  grid->next = NULL;
+}
+
+static void grid_hash_cell(struct grid_hash const *grid, double const *x,
+                           int64_t *cell)
+{
+  for (int j = 0; j < grid->dims; j++)
+    cell[j] = (int64_t)floor(x[j] * grid->inv_cell);
+}
+
+static size_t grid_hash_slot(struct grid_hash const *grid,
+                             int64_t const *cell)
+{
+  return murmurhash((char const *)cell, grid->dims * sizeof(int64_t),
+                    0x9747b28c) &
+         grid->mask;
+}
+
+static void grid_hash_place(struct grid_hash *grid, double const *x_distinct,
+                            size_t idx)
+{
+  int64_t cell[GRID_HASH_DIMS];
+
+  grid_hash_cell(grid, x_distinct + idx * grid->dimensions, cell);
+  size_t s = grid_hash_slot(grid, cell);
+  grid->next[idx] = grid->heads[s];
+  grid->heads[s] = idx + 1;
+}
+
+void grid_hash_insert(struct grid_hash *grid, double const *x_distinct,
+                      size_t idx)
+{
+  if (idx >= grid->next_cap)
+  {
+    grid->next_cap = MAX(idx + 1, 2 * grid->next_cap);
+    grid->next = realloc(grid->next, grid->next_cap * sizeof(size_t));
+  }
+
+  // keep the lists short, rehash x_distinct[0 : idx] into twice as many
+  // slots
+  if (2 * (idx + 1) > grid->mask + 1)
+  {
+    size_t n_slots = 2 * (grid->mask + 1);
+    free(grid->heads);
+    grid->heads = calloc(n_slots, sizeof(size_t));
+    grid->mask = n_slots - 1;
+    for (size_t k = 0; k < idx; k++)
+      grid_hash_place(grid, x_distinct, k);
+  }
+
+  grid_hash_place(grid, x_distinct, idx);
+}
+
+int grid_hash_has_close(struct grid_hash const *grid,
+                        double const *x_distinct, double const *x)
+{
+  size_t dimensions = grid->dimensions;
+  int dims = grid->dims;
+
+  int64_t center[GRID_HASH_DIMS];
+  int64_t cell[GRID_HASH_DIMS];
+  grid_hash_cell(grid, x, center);
+
+  int n_cells = 1;
+  for (int j = 0; j < dims; j++)
+    n_cells *= 3;
+
+  // the neighbour o has the offset digit_j(o) - 1 along the axis j
+  for (int o = 0; o < n_cells; o++)
+  {
+    int digits = o;
+    for (int j = 0; j < dims; j++)
+    {
+      cell[j] = center[j] + digits % 3 - 1;
+      digits /= 3;
+    }
+
+    for (size_t k = grid->heads[grid_hash_slot(grid, cell)]; k;
+         k = grid->next[k - 1])
+    {
+      double const *u = x_distinct + (k - 1) * dimensions;
+      if (dist2(dimensions, x, u) < grid->min_dist2)
+        return 1;
+    }
+  }
+  return 0;
+}
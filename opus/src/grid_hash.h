@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Hashed uniform grid over x_distinct, for exact distinctness checks
+ *
+ * The points are projected on their first GRID_HASH_DIMS coordinates and
+ * bucketed in cells of side min_dist. The projection does not increase
+ * distances, so every point closer than min_dist to x lies in the cell of x
+ * or in one of its 3^GRID_HASH_DIMS - 1 neighbours: only the points of
+ * these cells are compared to x, with the full distance.
+ *
+ * Cells are hashed to a power of two number of slots, each slot heads a
+ * list of the points hashed to it. Points of different cells sharing a slot
+ * only cost an extra distance computation.
+ */
+
+#ifndef GRID_HASH_DIMS
+#define GRID_HASH_DIMS 3
+#endif
+
+struct grid_hash
+{
+  // x_distinct index + 1 of the last point hashed to each slot, 0 if none
+  size_t *heads;
+  size_t mask;
+  // x_distinct index + 1 of the previous point of the same slot, 0 if none
+  size_t *next;
+  size_t next_cap;
+  // number of projected coordinates, at most GRID_HASH_DIMS
+  int dims;
+  size_t dimensions;
+  double inv_cell;
+  double min_dist2;
+};
+
+// capacity: the initial number of points in x_distinct, the grid grows
+// with it
+void grid_hash_init(struct grid_hash *grid, int dimensions, double min_dist,
+                    size_t capacity);
+void grid_hash_free(struct grid_hash *grid);
+
+// Index the point x_distinct[idx], points 0 .. idx - 1 are indexed
+void grid_hash_insert(struct grid_hash *grid, double const *x_distinct,
+                      size_t idx);
+// Whether a point of x_distinct is closer than min_dist to x, the test of
+// check_if_distinct (d2 < min_dist2)
+int grid_hash_has_close(struct grid_hash const *grid,
+                        double const *x_distinct, double const *x);
@@ -87,6 +87,14 @@ double dist2(size_t dim, double const *x, double const *y)
   return s;
 }
 
+double norm2(size_t dim, double const *x)
+{
+  double s = 0;
+  for (size_t i = 0; i < dim; i++)
+    s += x[i] * x[i];
+  return s;
+}
+
 double dist(size_t dim, double const *x, double const *y)
 {
   return sqrt(dist2(dim, x, y));
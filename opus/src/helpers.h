@@ -34,4 +34,5 @@ int randrange(int N);
 double rand_between(double a, double b);
 
 double dist2(size_t dim, double const *x, double const *y);
+double norm2(size_t dim, double const *x);
 double dist(size_t dim, double const *x, double const *y);
@@ -0,0 +1,273 @@
+#include "krylov_solve.h"
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+
+#include "my_papi.h"
+
+void krylov_initialize_memory(struct solver_context *ctx, int max_n,
+                              int max_m)
+{
+  ctx->krylov_r = malloc(max_n * sizeof(double));
+  ctx->krylov_g = malloc(max_n * sizeof(double));
+  ctx->krylov_d = malloc(max_n * sizeof(double));
+  ctx->krylov_q = malloc(max_n * sizeof(double));
+  ctx->krylov_dinv = malloc(max_n * sizeof(double));
+  ctx->krylov_s = malloc(max_m * max_m * sizeof(double));
+}
+
+void krylov_free_memory(struct solver_context *ctx)
+{
+  free(ctx->krylov_r);
+  free(ctx->krylov_g);
+  free(ctx->krylov_d);
+  free(ctx->krylov_q);
+  free(ctx->krylov_dinv);
+  free(ctx->krylov_s);
+  ctx->krylov_r = ctx->krylov_g = ctx->krylov_d = ctx->krylov_q = NULL;
+  ctx->krylov_dinv = ctx->krylov_s = NULL;
+}
+
+static inline double ddot_6(int N, double *x, double *y)
+{
+  int i = 0;
+  __m256d s0 = _mm256_setzero_pd();
+  __m256d s4 = _mm256_setzero_pd();
+
+  for (; i <= N - 8; i += 8)
+  {
+    s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 0),
+                         _mm256_loadu_pd(y + i + 0), s0);
+    s4 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4),
+                         _mm256_loadu_pd(y + i + 4), s4);
+  }
+  s0 = _mm256_add_pd(s0, s4);
+  __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s0),
+                         _mm256_extractf128_pd(s0, 1));
+  double s = _mm_cvtsd_f64(_mm_hadd_pd(h, h));
+
+  for (; i < N; ++i)
+    s += x[i] * y[i];
+  return s;
+}
+
+/** @brief One row of the packed symmetric product, in a single pass over
+ *         the row: y(0:q) += vq * row and the return value is row . v(0:q).
+ */
+static inline double dspmv_row_6(int q, double *row, double *v, double vq,
+                                 double *y)
+{
+  int i = 0;
+  __m256d vqv = _mm256_set1_pd(vq);
+  __m256d s0 = _mm256_setzero_pd();
+  __m256d s4 = _mm256_setzero_pd();
+
+  for (; i <= q - 8; i += 8)
+  {
+    __m256d a0 = _mm256_loadu_pd(row + i + 0);
+    __m256d a4 = _mm256_loadu_pd(row + i + 4);
+    s0 = _mm256_fmadd_pd(a0, _mm256_loadu_pd(v + i + 0), s0);
+    s4 = _mm256_fmadd_pd(a4, _mm256_loadu_pd(v + i + 4), s4);
+    _mm256_storeu_pd(y + i + 0,
+                     _mm256_fmadd_pd(vqv, a0, _mm256_loadu_pd(y + i + 0)));
+    _mm256_storeu_pd(y + i + 4,
+                     _mm256_fmadd_pd(vqv, a4, _mm256_loadu_pd(y + i + 4)));
+  }
+  s0 = _mm256_add_pd(s0, s4);
+  __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s0),
+                         _mm256_extractf128_pd(s0, 1));
+  double s = _mm_cvtsd_f64(_mm_hadd_pd(h, h));
+
+  for (; i < q; ++i)
+  {
+    s += row[i] * v[i];
+    y[i] += vq * row[i];
+  }
+  return s;
+}
+
+// y := A v, A symmetric with zero diagonal, packed strict lower triangle
+static void dspmv_6(int N, double *A, double *v, double *y)
+{
+  memset(y, 0, N * sizeof(double));
+  for (int i = 1; i < N; ++i)
+    y[i] += dspmv_row_6(i, A + i * (i - 1) / 2, v, v[i], y);
+}
+
+static int pcg_preconditioner(struct solver_context *ctx, int N, int M,
+                              double *A, double *P, int LDP)
+{
+  int i, j, k;
+  double s, *dinv = ctx->krylov_dinv, *S = ctx->krylov_s;
+
+  // Row sums of |A|
+  memset(dinv, 0, N * sizeof(double));
+  for (i = 1; i < N; ++i)
+  {
+    double *row = A + i * (i - 1) / 2;
+    s = 0.;
+    for (k = 0; k < i; ++k)
+    {
+      s += fabs(row[k]);
+      dinv[k] += fabs(row[k]);
+    }
+    dinv[i] += s;
+  }
+  for (i = 0; i < N; ++i)
+    dinv[i] = 0. < dinv[i] ? 1. / dinv[i] : 1.;
+
+  // S = L L^T = P^T D^-1 P
+  for (j = 0; j < M; ++j)
+    for (k = j; k < M; ++k)
+    {
+      s = 0.;
+      for (i = 0; i < N; ++i)
+        s += TIX(P, LDP, i, j) * TIX(P, LDP, i, k) * dinv[i];
+      TIX(S, M, k, j) = s;
+    }
+  for (j = 0; j < M; ++j)
+  {
+    s = TIX(S, M, j, j);
+    for (k = 0; k < j; ++k)
+      s -= TIX(S, M, j, k) * TIX(S, M, j, k);
+    if (s <= 0.)
+    {
+      fprintf(stderr, "ERROR: Krylov preconditioner is not definite\n");
+      return -1;
+    }
+    TIX(S, M, j, j) = sqrt(s);
+    for (i = j + 1; i < M; ++i)
+    {
+      s = TIX(S, M, i, j);
+      for (k = 0; k < j; ++k)
+        s -= TIX(S, M, i, k) * TIX(S, M, j, k);
+      TIX(S, M, i, j) = s / TIX(S, M, j, j);
+    }
+  }
+
+  return 0;
+}
+
+/** @brief Apply the constraint preconditioner, that is solve
+ *
+ *         [ D   P ] [ g ]   [ r ]
+ *         [ P^T 0 ] [ y ] = [ 0 ]
+ *
+ * g is the D^-1 weighted projection of D^-1 r onto the null space of P^T.
+ */
+static void pcg_precondition(struct solver_context *ctx, int N, int M,
+                             double *P, int LDP, double *r, double *g,
+                             double *y)
+{
+  int i, k;
+  double s, *dinv = ctx->krylov_dinv, *S = ctx->krylov_s;
+
+  for (i = 0; i < N; ++i)
+    g[i] = dinv[i] * r[i];
+
+  // y := S^-1 P^T D^-1 r
+  for (k = 0; k < M; ++k)
+    y[k] = ddot_6(N, &TIX(P, LDP, 0, k), g);
+  for (i = 0; i < M; ++i)
+  {
+    s = y[i];
+    for (k = 0; k < i; ++k)
+      s -= TIX(S, M, i, k) * y[k];
+    y[i] = s / TIX(S, M, i, i);
+  }
+  for (i = M - 1; i >= 0; --i)
+  {
+    s = y[i];
+    for (k = i + 1; k < M; ++k)
+      s -= TIX(S, M, k, i) * y[k];
+    y[i] = s / TIX(S, M, i, i);
+  }
+
+  // g := D^-1 (r - P y)
+  for (k = 0; k < M; ++k)
+  {
+    double *pk = &TIX(P, LDP, 0, k);
+    s = y[k];
+    for (i = 0; i < N; ++i)
+      g[i] -= dinv[i] * s * pk[i];
+  }
+}
+
+int projected_cg_solve(struct solver_context *ctx, int N, int M, double *A,
+                       double *P, int LDP, double *f, double *x)
+{
+  int i, it;
+  double *r = ctx->krylov_r, *g = ctx->krylov_g, *d = ctx->krylov_d,
+         *q = ctx->krylov_q;
+  double *c = x + N;
+  double rg, rg_next, alpha, beta, fg, tol;
+
+  if (N <= M)
+    return -1;
+
+  PAPI_START("projected_cg_solve");
+
+  if (pcg_preconditioner(ctx, N, M, A, P, LDP) < 0)
+  {
+    PAPI_STOP("projected_cg_solve");
+    return -1;
+  }
+
+  // The tolerance is relative to the preconditioned norm of f
+  pcg_precondition(ctx, N, M, P, LDP, f, g, c);
+  fg = fabs(ddot_6(N, f, g));
+  tol = KRYLOV_TOL * KRYLOV_TOL * fg;
+
+  // Move the initial guess into the null space of P^T: lambda -= D^-1 P y
+  // with P^T lambda = P^T D^-1 P y.
+  for (i = 0; i < N; ++i)
+    r[i] = x[i] / ctx->krylov_dinv[i];
+  pcg_precondition(ctx, N, M, P, LDP, r, x, c);
+
+  // r := A lambda - f
+  dspmv_6(N, A, x, r);
+  for (i = 0; i < N; ++i)
+    r[i] -= f[i];
+  pcg_precondition(ctx, N, M, P, LDP, r, g, c);
+  rg = ddot_6(N, r, g);
+  for (i = 0; i < N; ++i)
+    d[i] = -g[i];
+
+  for (it = 0; it < KRYLOV_MAX_ITER && tol < rg; ++it)
+  {
+    dspmv_6(N, A, d, q);
+    alpha = ddot_6(N, d, q);
+    // A is positive definite on the null space of P^T, a non positive
+    // curvature is rounding noise: lambda is as accurate as it gets.
+    if (!(0. < alpha))
+      break;
+    alpha = rg / alpha;
+
+    for (i = 0; i < N; ++i)
+    {
+      x[i] += alpha * d[i];
+      r[i] += alpha * q[i];
+    }
+    pcg_precondition(ctx, N, M, P, LDP, r, g, c);
+    rg_next = ddot_6(N, r, g);
+    beta = rg_next / rg;
+    rg = rg_next;
+    for (i = 0; i < N; ++i)
+      d[i] = beta * d[i] - g[i];
+  }
+
+  // A lambda - f = -P c on convergence, y of the last preconditioner solve
+  // is the (D^-1 weighted) least squares c.
+  for (i = 0; i < M; ++i)
+    c[i] = -c[i];
+
+  ctx->krylov_residual = 0. < fg ? sqrt(fabs(rg) / fg) : 0.;
+
+  PAPI_STOP("projected_cg_solve");
+  return it;
+}
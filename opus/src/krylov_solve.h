@@ -0,0 +1,56 @@
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "solver_context.h"
+
+// Stop once the preconditioned residual dropped by this factor relative to
+// the right hand side. The cubic kernel is too ill conditioned on clustered
+// points for much tighter tolerances.
+#ifndef KRYLOV_TOL
+#define KRYLOV_TOL 1.E-6
+#endif
+
+#ifndef KRYLOV_MAX_ITER
+#define KRYLOV_MAX_ITER 2000
+#endif
+
+/** @brief Solve the saddle point system
+ *
+ *         [ A   P ] [ lambda ]   [ f ]
+ *         [ P^T 0 ] [ c      ] = [ 0 ]
+ *
+ * with projected preconditioned conjugate gradients. A is conditionally
+ * positive definite with respect to the columns of P, so CG on the null
+ * space of P^T is well defined. The constraint preconditioner
+ *
+ *         [ D   P ]
+ *         [ P^T 0 ],  D = diag(|A|_1 row sums)
+ *
+ * keeps every iterate in that null space, applying it costs O(N * M).
+ *
+ * A is never materialized, every product streams once over its strict lower
+ * triangle stored packed by rows (row q starts at A + q * (q - 1) / 2 and
+ * holds the q entries left of the diagonal, the diagonal is zero), that is
+ * the layout of the phi cache filled by check_if_distinct.
+ *
+ * @param ctx: Workspace from krylov_initialize_memory.
+ * @param N: Number of rows of A and P.
+ * @param M: Number of columns of P, N > M.
+ * @param A: Packed strict lower triangle of A.
+ * @param P: NxM matrix (transposed layout).
+ * @param LDP: The leading dimension of P.
+ * @param f: The right hand side, N elements.
+ * @param x: On entry the initial guess for (lambda || c), only lambda is
+ *           used. On exit the solution, N + M elements.
+ * @return: The number of iterations, KRYLOV_MAX_ITER if CG did not converge
+ *          (x then holds the last iterate). <0 if P does not have full
+ *          rank. ctx->krylov_residual is set to the final relative
+ *          preconditioned residual.
+ */
+int projected_cg_solve(struct solver_context *ctx, int N, int M, double *A,
+                       double *P, int LDP, double *f, double *x);
+void krylov_initialize_memory(struct solver_context *ctx, int max_n,
+                              int max_m);
+void krylov_free_memory(struct solver_context *ctx);
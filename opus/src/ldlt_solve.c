@@ -0,0 +1,254 @@
+#include "ldlt_solve.h"
+
+#include <float.h>
+#include <immintrin.h>
+#include <math.h>
+#include <stdlib.h>
+
+// BLAS subroutines
+#include "blas/dgemm.h"
+#include "blas/dsytrf.h"
+#include "blas/dsytrs.h"
+
+#include "helpers.h"
+
+#include "my_papi.h"
+
+// ldlt_factor_border rejects the bordered factors if an entry of L21 * D or
+// of the new D grows past LDLT_BORDER_GROWTH * max|A|
+#ifndef LDLT_BORDER_GROWTH
+#define LDLT_BORDER_GROWTH 1e3
+#endif
+
+void ldlt_initialize_memory(struct solver_context *ctx, int max_n)
+{
+  solver_context_dgemm_work(ctx);
+  ctx->ldlt_ipiv = (int *)aligned_alloc(32, (max_n * sizeof(int) + 31) & -32);
+  ctx->ldlt_w = (double *)aligned_alloc(
+      32, (2 * (size_t)max_n * LDLT_BLOCK * sizeof(double) + 31) & -32);
+}
+
+void ldlt_free_memory(struct solver_context *ctx)
+{
+  free(ctx->ldlt_ipiv);
+  free(ctx->ldlt_w);
+  ctx->ldlt_ipiv = NULL;
+  ctx->ldlt_w = NULL;
+}
+
+int ldlt_solve(struct solver_context *ctx, int N, double *A, double *b)
+{
+  PAPI_START("ldlt_solve");
+  int ret = dsytrf_6(N, 0, A, N, ctx->ldlt_ipiv, ctx->ldlt_w, ctx->dgemm_work);
+  if (ret == 0)
+    ret = dsytrs_6(N, A, N, ctx->ldlt_ipiv, b);
+  PAPI_STOP("ldlt_solve");
+  return ret;
+}
+
+// Largest magnitude of the entries of X
+static double dmax_abs(int M, double const *X)
+{
+  double xmax = 0.;
+  for (int i = 0; i < M; ++i)
+    xmax = MAX(xmax, fabs(X[i]));
+  return xmax;
+}
+
+int ldlt_factor(struct solver_context *ctx, int N, double *A, int LDA,
+                int *ipiv)
+{
+  PAPI_START("ldlt_factor");
+  ctx->ldlt_amax = 0.;
+  for (int j = 0; j < N; ++j)
+    ctx->ldlt_amax = MAX(ctx->ldlt_amax, dmax_abs(N - j, &TIX(A, LDA, j, j)));
+  int ret = dsytrf_6(N, 0, A, LDA, ipiv, ctx->ldlt_w, ctx->dgemm_work);
+  PAPI_STOP("ldlt_factor");
+  return ret;
+}
+
+// Y := Y - s * X
+static inline void daxpy_neg(int M, double s, double *X, double *Y)
+{
+  int i = 0;
+  __m256d sp = _mm256_set1_pd(s);
+
+  for (; i <= M - 4; i += 4)
+  {
+    __m256d y0 = _mm256_loadu_pd(Y + i);
+    y0 = _mm256_fnmadd_pd(sp, _mm256_loadu_pd(X + i), y0);
+    _mm256_storeu_pd(Y + i, y0);
+  }
+  for (; i < M; ++i)
+    Y[i] -= s * X[i];
+}
+
+static inline void dswap_cols(int M, double *X, double *Y)
+{
+  double t;
+  for (int i = 0; i < M; ++i)
+  {
+    t = X[i];
+    X[i] = Y[i];
+    Y[i] = t;
+  }
+}
+
+int ldlt_factor_border(struct solver_context *ctx, int N, int K, double *A,
+                       int LDA, int *ipiv)
+{
+  int i, j, l, kp, step;
+  double d, d11, d21, d22, t, x0, x1, y0, y1, amax, xmax;
+
+  // Nothing factored yet, the border is the whole matrix
+  if (N == 0)
+    return ldlt_factor(ctx, K, A, LDA, ipiv);
+
+  PAPI_START("ldlt_factor_border");
+
+  // The border B^T lives in rows N : N + K of columns 0 : N, every column
+  // of it is a contiguous vector of K elements.
+#define BT(COL) (&TIX(A, LDA, N, COL))
+#define S(ROW, COL) TIX(A, LDA, N + (ROW), N + (COL))
+
+  // Largest entry of the grown matrix, before the border is overwritten
+  amax = ctx->ldlt_amax;
+  for (j = 0; j < N; ++j)
+    amax = MAX(amax, dmax_abs(K, BT(j)));
+  for (l = 0; l < K; ++l)
+    amax = MAX(amax, dmax_abs(K - l, &S(l, l)));
+
+  // B^T := B^T * P^T
+  for (j = 0; j < N; j += step)
+  {
+    if (ipiv[j] >= 0)
+    {
+      step = 1;
+      if (ipiv[j] != j)
+        dswap_cols(K, BT(j), BT(ipiv[j]));
+    }
+    else
+    {
+      step = 2;
+      kp = -1 - ipiv[j];
+      if (kp != j + 1)
+        dswap_cols(K, BT(j + 1), BT(kp));
+    }
+  }
+
+  // X^T := B^T * L^-T, right looking over the columns of L
+  for (j = 0; j < N; j += step)
+  {
+    step = ipiv[j] >= 0 ? 1 : 2;
+    for (l = j + step; l < N; ++l)
+    {
+      daxpy_neg(K, TIX(A, LDA, l, j), BT(j), BT(l));
+      if (step == 2)
+        daxpy_neg(K, TIX(A, LDA, l, j + 1), BT(j + 1), BT(l));
+    }
+  }
+
+  xmax = 0.;
+  for (j = 0; j < N; ++j)
+    xmax = MAX(xmax, dmax_abs(K, BT(j)));
+
+  // L21 := X^T * D^-1 and S := C - L21 * D * L21^T (lower triangle), one
+  // block of D at a time.
+  for (j = 0; j < N; j += step)
+  {
+    if (ipiv[j] >= 0)
+    {
+      step = 1;
+      d = TIX(A, LDA, j, j);
+      t = 1. / d;
+      for (i = 0; i < K; ++i)
+        BT(j)[i] *= t;
+
+      for (l = 0; l < K; ++l)
+        daxpy_neg(K - l, d * BT(j)[l], BT(j) + l, &S(l, l));
+    }
+    else
+    {
+      step = 2;
+      d21 = TIX(A, LDA, j + 1, j);
+      d11 = TIX(A, LDA, j + 1, j + 1) / d21;
+      d22 = TIX(A, LDA, j, j) / d21;
+      t = 1. / (d11 * d22 - 1.);
+      d21 = t / d21;
+
+      for (i = 0; i < K; ++i)
+      {
+        x0 = BT(j)[i];
+        x1 = BT(j + 1)[i];
+        BT(j)[i] = d21 * (d11 * x0 - x1);
+        BT(j + 1)[i] = d21 * (d22 * x1 - x0);
+      }
+
+      for (l = 0; l < K; ++l)
+      {
+        // X^T = L21 * D, recover row l of it
+        y0 = BT(j)[l];
+        y1 = BT(j + 1)[l];
+        x0 = TIX(A, LDA, j, j) * y0 + TIX(A, LDA, j + 1, j) * y1;
+        x1 = TIX(A, LDA, j + 1, j) * y0 + TIX(A, LDA, j + 1, j + 1) * y1;
+        daxpy_neg(K - l, x0, BT(j) + l, &S(l, l));
+        daxpy_neg(K - l, x1, BT(j + 1) + l, &S(l, l));
+      }
+    }
+  }
+
+#undef BT
+#undef S
+
+  // Factor the Schur complement, its interchanges are applied to L21
+  int ret = dsytrf_6(N + K, N, A, LDA, ipiv, ctx->ldlt_w, ctx->dgemm_work);
+
+  // Accept the border only if X = L21 * D and the new blocks of D did not
+  // grow, and none of those blocks is numerically singular, as in
+  // lu_factor_border
+  if (ret == 0)
+  {
+    double dmax = xmax, pmin = INFINITY;
+    for (j = N; j < N + K; j += step)
+    {
+      if (ipiv[j] >= 0)
+      {
+        step = 1;
+        d = fabs(TIX(A, LDA, j, j));
+        dmax = MAX(dmax, d);
+        pmin = MIN(pmin, d);
+      }
+      else
+      {
+        // |det| / ||D_jj||_inf is within 2 of the smaller eigenvalue
+        step = 2;
+        d11 = TIX(A, LDA, j, j);
+        d21 = TIX(A, LDA, j + 1, j);
+        d22 = TIX(A, LDA, j + 1, j + 1);
+        d = MAX(fabs(d11), fabs(d22)) + fabs(d21);
+        dmax = MAX(dmax, d);
+        pmin = MIN(pmin, fabs(d11 * d22 - d21 * d21) / d);
+      }
+    }
+    if (LDLT_BORDER_GROWTH * amax < dmax ||
+        pmin < (N + K) * DBL_EPSILON * amax)
+      ret = 1;
+    else
+      ctx->ldlt_amax = amax;
+  }
+
+  PAPI_STOP("ldlt_factor_border");
+  return ret;
+}
+
+int ldlt_solve_factored(struct solver_context *ctx, int N, double *A, int LDA,
+                        int *ipiv, double *b)
+{
+  // same signature as lu_solve_factored, dsytrs needs no workspace
+  (void)ctx;
+
+  PAPI_START("ldlt_solve_factored");
+  int ret = dsytrs_6(N, A, LDA, ipiv, b);
+  PAPI_STOP("ldlt_solve_factored");
+  return ret;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "solver_context.h"
+
+/** @brief Solve symmetric (indefinite) linear systems using a Bunch-Kaufman
+ *         LDL^T factorization. Only the lower triangle of A is referenced,
+ *         which halves the flops of lu_solve. The storage is not packed:
+ *         A stays a full square array whose strict upper triangle is
+ *         left untouched, so the memory footprint is that of lu_solve.
+ *
+ * @param ctx: Workspace from ldlt_initialize_memory.
+ * @param N: The length of one side.
+ * @param A: The segment of memory representing a symmetric square matrix
+ *           layed out sequentially in memory.
+ * @param b: Column vector b in Ax=b, overwritten with x.
+ * @return: 0 on success. <0 for matrix singularity.
+ */
+int ldlt_solve(struct solver_context *ctx, int N, double *A, double *b);
+void ldlt_initialize_memory(struct solver_context *ctx, int max_n);
+void ldlt_free_memory(struct solver_context *ctx);
+
+/** @brief Factor the leading N x N block of the symmetric matrix A into
+ *         P^T L D L^T P in place (lower triangle, transposed layout with
+ *         leading dimension LDA >= N).
+ *
+ * @return: 0 on success. <0 for matrix singularity.
+ */
+int ldlt_factor(struct solver_context *ctx, int N, double *A, int LDA,
+                int *ipiv);
+
+/** @brief Extend a factorization of the leading N x N block of A to the
+ *         leading (N + K) x (N + K) block.
+ *
+ * On entry rows N : N + K of A hold the raw lower triangle of the border of
+ * the grown matrix and the leading block holds the factors and ipiv from a
+ * previous ldlt_factor / ldlt_factor_border. The border is eliminated in
+ * O(N^2 * K) and only the K x K Schur complement is pivoted.
+ *
+ * @return: 0 on success. <0 if the Schur complement is singular, >0 if the
+ *          bordered factors grew (see LDLT_BORDER_GROWTH) or a block of
+ *          D fell below the rank tolerance (N + K) * eps * max|A|. In both
+ *          cases A is clobbered and the caller has to refactor from scratch.
+ */
+int ldlt_factor_border(struct solver_context *ctx, int N, int K, double *A,
+                       int LDA, int *ipiv);
+
+/** @brief Solve A * x = b with a factorization from ldlt_factor /
+ *         ldlt_factor_border. After exit b is overwritten with x.
+ */
+int ldlt_solve_factored(struct solver_context *ctx, int N, double *A, int LDA,
+                        int *ipiv, double *b);
@@ -2,7 +2,8 @@
 #include "local_refinement.h"
 
 #include <float.h>
-#include <stdlib.h>
+#include <math.h>
+#include <string.h>
 
 void local_optimization(local_optimization_function f, // R^d -> R
                         size_t dimensions,             // R
@@ -10,16 +11,17 @@ void local_optimization(local_optimization_function f, // R^d -> R
                         double xi,                     // R
                         double const *a,               // R^d
                         double const *b,               // R^d
-                        void const *const additionnal_f_args, double *x_min)
+                        void const *const additionnal_f_args, double *x_min,
+                        double *work)
 {
   // hyperparameter
-  const size_t divisions = 10;
+  const size_t divisions = LOCAL_OPTIMIZATION_DIVISIONS;
 
   /* Performing the intersection:
       [lo; hi] = [x-eta; x+eta] \and [a; b]
   */
-  double *space_lo = (double *)malloc(sizeof(double) * dimensions);
-  double *space_hi = (double *)malloc(sizeof(double) * dimensions);
+  double *space_lo = work;
+  double *space_hi = work + dimensions;
 
   for (size_t it = 0; it < dimensions; ++it)
   {
@@ -32,9 +34,9 @@ void local_optimization(local_optimization_function f, // R^d -> R
   for (size_t it = 0; it < dimensions; ++it)
   {
     if (b[it] >= center[it] + xi)
-      space_lo[it] = center[it] + xi;
+      space_hi[it] = center[it] + xi;
     else
-      space_lo[it] = b[it];
+      space_hi[it] = b[it];
   }
 
   /*  Dividing the space [lo; hi] into a grid.
@@ -43,8 +45,7 @@ void local_optimization(local_optimization_function f, // R^d -> R
   */
 
   // c_k = grid_centers[k * divisions .. k * divisions + dimensions]
-  double *grid_centers =
-      (double *)malloc(divisions * dimensions * sizeof(double));
+  double *grid_centers = work + 2 * dimensions;
   for (size_t div_it = 0; div_it < divisions; ++div_it)
   {
     for (size_t dim_it = 0; dim_it < dimensions; ++dim_it)
@@ -77,10 +78,173 @@ void local_optimization(local_optimization_function f, // R^d -> R
   {
     x_min[i] = grid_centers[best_center_index * dimensions + i];
   }
+}
+
+static double dot(size_t n, double const *x, double const *y)
+{
+  double s = 0;
+  for (size_t i = 0; i < n; i++)
+    s += x[i] * y[i];
+  return s;
+}
+
+static double clamp(double x, double lo, double hi)
+{
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+/*
+ * Projected L-BFGS on [lo; hi] = [center - xi; center + xi] \and [a; b]
+ *
+ * The variables held at a bound by the gradient are frozen, the L-BFGS
+ * direction (two-loop recursion over the last LOCAL_OPTIMIZATION_MEMORY
+ * steps) is taken on the free ones, and a backtracking line search on the
+ * projection of the step onto the box enforces the Armijo condition. Every
+ * iteration costs one evaluation of f and its gradient when the full step
+ * is accepted.
+ */
+void local_optimization_lbfgsb(local_optimization_grad_function fg,
+                               size_t dimensions, double const *center,
+                               double xi, double const *a, double const *b,
+                               void const *const additionnal_f_args,
+                               double *x_min, double *work)
+{
+  const size_t d = dimensions;
+  const int m = LOCAL_OPTIMIZATION_MEMORY;
+
+  double *lo = work;
+  double *hi = lo + d;
+  double *x = hi + d;
+  double *g = x + d;
+  double *x_new = g + d;
+  double *g_new = x_new + d;
+  double *p = g_new + d;
+  // s_j = x_(j+1) - x_j and y_j = g_(j+1) - g_j, in a ring
+  double *s_mem = p + d;
+  double *y_mem = s_mem + m * d;
+  double *rho = y_mem + m * d;
+  double *alpha = rho + m;
+  // the variables not held at a bound
+  unsigned char *free_var = (unsigned char *)(alpha + m);
+
+  for (size_t i = 0; i < d; i++)
+  {
+    lo[i] = fmax(a[i], center[i] - xi);
+    hi[i] = fmin(b[i], center[i] + xi);
+    x[i] = clamp(center[i], lo[i], hi[i]);
+  }
+
+  double f = fg(x, g, additionnal_f_args);
+  int n_pairs = 0, newest = -1;
+
+  for (int it = 0; it < LOCAL_OPTIMIZATION_ITERATIONS; it++)
+  {
+    // steepest descent on the free variables, and the projected gradient
+    double pg_norm = 0;
+    for (size_t i = 0; i < d; i++)
+    {
+      int held = (x[i] <= lo[i] && g[i] > 0) || (x[i] >= hi[i] && g[i] < 0);
+      free_var[i] = !held;
+      p[i] = held ? 0 : -g[i];
+      pg_norm = fmax(pg_norm, fabs(clamp(x[i] - g[i], lo[i], hi[i]) - x[i]));
+    }
+    if (pg_norm <= LOCAL_OPTIMIZATION_TOLERANCE)
+      break;
+
+    // p = -H g on the free variables, two-loop recursion
+    double *q = x_new;
+    memcpy(q, p, d * sizeof(double));
+    for (int j = 0; j < n_pairs; j++)
+    {
+      int r = (newest - j + m) % m;
+      alpha[r] = rho[r] * dot(d, s_mem + r * d, q);
+      for (size_t i = 0; i < d; i++)
+        q[i] -= alpha[r] * y_mem[r * d + i];
+    }
+    if (n_pairs > 0)
+    {
+      double const *s = s_mem + newest * d, *y = y_mem + newest * d;
+      double gamma = dot(d, s, y) / dot(d, y, y);
+      for (size_t i = 0; i < d; i++)
+        q[i] *= gamma;
+    }
+    for (int j = n_pairs - 1; j >= 0; j--)
+    {
+      int r = (newest - j + m) % m;
+      double beta = rho[r] * dot(d, y_mem + r * d, q);
+      for (size_t i = 0; i < d; i++)
+        q[i] += (alpha[r] - beta) * s_mem[r * d + i];
+    }
+    // keep the steepest descent if it is not a descent direction
+    double q_g = 0;
+    for (size_t i = 0; i < d; i++)
+    {
+      if (free_var[i])
+        q_g += q[i] * g[i];
+    }
+    if (n_pairs > 0 && q_g < 0)
+    {
+      for (size_t i = 0; i < d; i++)
+        p[i] = free_var[i] ? q[i] : 0;
+    }
+
+    // the first step is scaled to the box
+    double t = 1;
+    if (n_pairs == 0)
+    {
+      double p_max = 0;
+      for (size_t i = 0; i < d; i++)
+        p_max = fmax(p_max, fabs(p[i]));
+      t = fmin(1., xi / p_max);
+    }
 
-  // De-allocate
+    double f_new = f;
+    int accepted = 0;
+    for (int ls = 0; ls < LOCAL_OPTIMIZATION_LINE_SEARCH && !accepted; ls++)
+    {
+      for (size_t i = 0; i < d; i++)
+        x_new[i] = clamp(x[i] + t * p[i], lo[i], hi[i]);
+      f_new = fg(x_new, g_new, additionnal_f_args);
+
+      double decrease = 0;
+      for (size_t i = 0; i < d; i++)
+        decrease += g[i] * (x_new[i] - x[i]);
+      accepted = f_new <= f + 1e-4 * decrease;
+      t *= 0.5;
+    }
+    if (!accepted)
+      break;
+
+    // remember the step if the curvature is positive. The pair only goes
+    // to the ring once accepted, a full ring still holds the oldest one.
+    double sy = 0, yy = 0;
+    for (size_t i = 0; i < d; i++)
+    {
+      double s_i = x_new[i] - x[i], y_i = g_new[i] - g[i];
+      sy += s_i * y_i;
+      yy += y_i * y_i;
+    }
+    if (sy > 1e-10 * yy)
+    {
+      int next = (newest + 1) % m;
+      double *s = s_mem + next * d, *y = y_mem + next * d;
+      for (size_t i = 0; i < d; i++)
+      {
+        s[i] = x_new[i] - x[i];
+        y[i] = g_new[i] - g[i];
+      }
+      rho[next] = 1. / sy;
+      newest = next;
+      if (n_pairs < m)
+        n_pairs++;
+    }
+
+    double *swap = x;
+    x = x_new, x_new = swap;
+    swap = g;
+    g = g_new, g_new = swap;
+    f = f_new;
+  }
 
-  free(space_lo);
-  free(space_hi);
-  free(grid_centers);
+  memcpy(x_min, x, d * sizeof(double));
 }
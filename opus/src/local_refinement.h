@@ -2,13 +2,56 @@
 
 #include <sys/types.h>
 
+#include "helpers.h"
+
 typedef double (*local_optimization_function)(double const *const,
                                               void const *const);
 
+// f and its gradient (second argument)
+typedef double (*local_optimization_grad_function)(double const *const,
+                                                   double *const,
+                                                   void const *const);
+
+#define LOCAL_OPTIMIZATION_DIVISIONS 10
+
+// L-BFGS iterations, stored steps, halvings of the line search and
+// tolerance on the projected gradient of local_optimization_lbfgsb
+#ifndef LOCAL_OPTIMIZATION_ITERATIONS
+#define LOCAL_OPTIMIZATION_ITERATIONS 20
+#endif
+#ifndef LOCAL_OPTIMIZATION_MEMORY
+#define LOCAL_OPTIMIZATION_MEMORY 5
+#endif
+#define LOCAL_OPTIMIZATION_LINE_SEARCH 20
+#define LOCAL_OPTIMIZATION_TOLERANCE 1e-8
+
+// Local refinements run by step10_opt2 from the best personal bests, one
+// per thread with WITH_OPENMP=1
+#ifndef LOCAL_REFINEMENT_STARTS
+#define LOCAL_REFINEMENT_STARTS 4
+#endif
+
+// Size in doubles of the work buffer of local_optimization and
+// local_optimization_lbfgsb (its mask of the free variables is counted as d
+// doubles)
+#define LOCAL_OPTIMIZATION_WORK_SIZE(dimensions)                               \
+  MAX((2 + LOCAL_OPTIMIZATION_DIVISIONS) * (dimensions),                       \
+      (8 + 2 * LOCAL_OPTIMIZATION_MEMORY) * (dimensions) +                     \
+          2 * LOCAL_OPTIMIZATION_MEMORY)
+
 void local_optimization(local_optimization_function f, // R^d -> R
                         size_t dimensions,             // R
                         double const *center,          // R^d
                         double xi,                     // R
                         double const *a,               // R^d
                         double const *b,               // R^d
-                        void const *const additionnal_f_args, double *x_min);
+                        void const *const additionnal_f_args, double *x_min,
+                        double *work); // LOCAL_OPTIMIZATION_WORK_SIZE
+
+// Minimize f in the same box by projected L-BFGS from the center
+void local_optimization_lbfgsb(local_optimization_grad_function fg,
+                               size_t dimensions, double const *center,
+                               double xi, double const *a, double const *b,
+                               void const *const additionnal_f_args,
+                               double *x_min,
+                               double *work); // LOCAL_OPTIMIZATION_WORK_SIZE
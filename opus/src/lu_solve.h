@@ -3,8 +3,11 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "solver_context.h"
+
 /** @brief Solve linear systems using LU factorization method.
  *
+ * @param ctx: Workspace from lu_initialize_memory.
  * @param A: The segment of memory representing a row-major square
  *           matrix layed out sequentially in memory.
  * @param b: Column vector b in Ax=b
@@ -13,9 +16,43 @@
  * @param N: The length of one side.
  * @return: 0 on success. <0 for matrix singularity.
  */
-int lu_solve(int N, double *A, double *b);
-void lu_initialize_memory(int max_n);
-void lu_free_memory();
+int lu_solve(struct solver_context *ctx, int N, double *A, double *b);
+
+/** @brief Factor the leading N x N block of A into [L\U] in place.
+ *
+ * A is stored transposed (column-major) with leading dimension LDA >= N,
+ * the layout used by lu_solve_6.
+ *
+ * @return: 0 on success. <0 for matrix singularity.
+ */
+int lu_factor(struct solver_context *ctx, int N, double *A, int LDA,
+              int *ipiv);
+
+/** @brief Extend a factorization of the leading N x N block of A to the
+ *         leading (N + K) x (N + K) block.
+ *
+ * On entry rows / columns N : N + K of A hold the raw border of the grown
+ * matrix and the leading block holds [L\U] and ipiv from a previous
+ * lu_factor / lu_factor_border. The border is eliminated against the old
+ * factors in O(N^2 * K) and only the K x K Schur complement is pivoted, so
+ * interchanges never cross from the new rows into the old ones.
+ *
+ * @return: 0 on success. <0 if the Schur complement is singular, >0 if the
+ *          bordered factors grew (see LU_BORDER_GROWTH) or a pivot fell
+ *          below the rank tolerance (N + K) * eps * max|A|. In both cases
+ *          A is clobbered and the caller has to refactor from scratch.
+ */
+int lu_factor_border(struct solver_context *ctx, int N, int K, double *A,
+                     int LDA, int *ipiv);
+
+/** @brief Solve A * x = b with a factorization from lu_factor /
+ *         lu_factor_border. After exit b is overwritten with x.
+ */
+int lu_solve_factored(struct solver_context *ctx, int N, double *A, int LDA,
+                      int *ipiv, double *b);
+
+void lu_initialize_memory(struct solver_context *ctx, int max_n);
+void lu_free_memory(struct solver_context *ctx);
 
 #ifdef TEST_PERF
 
@@ -82,8 +82,9 @@ static double drand()
 
 int main()
 {
-
-  lu_initialize_memory(N);
+  struct solver_context ctx;
+  solver_context_init(&ctx);
+  lu_initialize_memory(&ctx, N);
 
   /* double *A = (double *)aligned_alloc(32, CLAMP(N * N) * sizeof(double)); */
   /* double *b = (double *)aligned_alloc(32, CLAMP(N) * sizeof(double)); */
@@ -140,7 +141,7 @@ int main()
   /* assert_equal(C0, C1, M, N); */
   /* perf_test_lu_solve(N, A, ipiv, b); */
 
-  lu_free_memory();
+  solver_context_free(&ctx);
 
   return 0;
 }
@@ -0,0 +1,188 @@
+#include "nullspace_solve.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// BLAS subroutines
+#include "blas/dgemm.h"
+#include "blas/dgeqr2.h"
+#include "blas/dlarft.h"
+#include "blas/dpotrf.h"
+#include "blas/dpotrs.h"
+
+#include "helpers.h"
+
+#include "my_papi.h"
+
+void nullspace_initialize_memory(struct solver_context *ctx, int max_n,
+                                 int max_m)
+{
+  size_t nm = (size_t)max_n * max_m;
+
+  solver_context_dgemm_work(ctx);
+  ctx->ns_tau = malloc(max_m * sizeof(double));
+  ctx->ns_t = malloc(max_m * max_m * sizeof(double));
+  ctx->ns_v = malloc(nm * sizeof(double));
+  ctx->ns_vt = malloc(nm * sizeof(double));
+  ctx->ns_x = malloc(nm * sizeof(double));
+  ctx->ns_w = malloc(nm * sizeof(double));
+  ctx->ns_wt = malloc(nm * sizeof(double));
+  ctx->ns_mm = malloc(2 * max_m * max_m * sizeof(double));
+  ctx->ns_chol = malloc((size_t)CHOL_BLOCK * max_n * sizeof(double));
+  ctx->ns_g = malloc(max_n * sizeof(double));
+}
+
+void nullspace_free_memory(struct solver_context *ctx)
+{
+  free(ctx->ns_tau);
+  free(ctx->ns_t);
+  free(ctx->ns_v);
+  free(ctx->ns_vt);
+  free(ctx->ns_x);
+  free(ctx->ns_w);
+  free(ctx->ns_wt);
+  free(ctx->ns_mm);
+  free(ctx->ns_chol);
+  free(ctx->ns_g);
+  ctx->ns_tau = ctx->ns_t = ctx->ns_v = ctx->ns_vt = NULL;
+  ctx->ns_x = ctx->ns_w = ctx->ns_wt = ctx->ns_mm = NULL;
+  ctx->ns_chol = ctx->ns_g = NULL;
+}
+
+// y := H_j y = (I - tau_j v_j v_j^T) y
+static inline void apply_reflector(int N, double *V, int LDV, int j,
+                                   double tau, double *y)
+{
+  double s = y[j];
+  for (int r = j + 1; r < N; ++r)
+    s += TIX(V, LDV, r, j) * y[r];
+  s *= tau;
+  y[j] -= s;
+  for (int r = j + 1; r < N; ++r)
+    y[r] -= s * TIX(V, LDV, r, j);
+}
+
+int nullspace_solve(struct solver_context *ctx, int N, int M, double *A,
+                    int LDA, double *P, int LDP, double *f, double *x)
+{
+  int i, j, l, r;
+  double s;
+
+  double *tau = ctx->ns_tau, *T = ctx->ns_t, *V = ctx->ns_v, *Vt = ctx->ns_vt,
+         *X = ctx->ns_x, *W = ctx->ns_w, *Wt = ctx->ns_wt, *g = ctx->ns_g,
+         *work = ctx->dgemm_work;
+
+  if (N <= M)
+    return -1;
+
+  PAPI_START("nullspace_solve");
+
+  // P = Q R, Q = I - V T V^T
+  dgeqr2_6(N, M, P, LDP, tau);
+  dlarft_6(N, M, P, LDP, tau, T, M);
+
+  for (j = 0; j < M; ++j)
+  {
+    for (r = 0; r < j; ++r)
+      TIX(V, N, r, j) = 0.;
+    TIX(V, N, j, j) = 1.;
+    for (r = j + 1; r < N; ++r)
+      TIX(V, N, r, j) = TIX(P, LDP, r, j);
+  }
+
+  // X := -A V
+  memset(X, 0, (size_t)N * M * sizeof(double));
+  dgemm_5(N, M, N, -1., A, LDA, V, N, 1., X, N, work);
+
+  // W := A V T = -X T
+  for (j = 0; j < M; ++j)
+    for (r = 0; r < N; ++r)
+    {
+      s = 0.;
+      for (l = 0; l <= j; ++l)
+        s -= TIX(X, N, r, l) * TIX(T, M, l, j);
+      TIX(W, N, r, j) = s;
+    }
+
+  // W := W - 1/2 V (T^T V^T W), so that Q^T A Q = A - W V^T - V W^T.
+  double *VtW = ctx->ns_mm, *TtVtW = ctx->ns_mm + M * M;
+  for (i = 0; i < M; ++i)
+    for (j = 0; j < M; ++j)
+    {
+      s = 0.;
+      for (r = i; r < N; ++r)
+        s += TIX(V, N, r, i) * TIX(W, N, r, j);
+      TIX(VtW, M, i, j) = s;
+    }
+  for (i = 0; i < M; ++i)
+    for (j = 0; j < M; ++j)
+    {
+      s = 0.;
+      for (l = 0; l <= i; ++l)
+        s += TIX(T, M, l, i) * TIX(VtW, M, l, j);
+      TIX(TtVtW, M, i, j) = 0.5 * s;
+    }
+  for (j = 0; j < M; ++j)
+    for (l = 0; l < M; ++l)
+    {
+      s = TIX(TtVtW, M, l, j);
+      for (r = l; r < N; ++r)
+        TIX(W, N, r, j) -= TIX(V, N, r, l) * s;
+    }
+
+  for (r = 0; r < N; ++r)
+    for (j = 0; j < M; ++j)
+    {
+      TIX(Vt, M, j, r) = TIX(V, N, r, j);
+      TIX(Wt, M, j, r) = TIX(W, N, r, j);
+    }
+
+  // Rows M : N of Q^T A Q, that is [Q2^T A Q1  Q2^T A Q2]
+  dgemm_5(N - M, N, M, -1., &TIX(W, N, M, 0), N, Vt, M, 1.,
+          &TIX(A, LDA, M, 0), LDA, work);
+  dgemm_5(N - M, N, M, -1., &TIX(V, N, M, 0), N, Wt, M, 1.,
+          &TIX(A, LDA, M, 0), LDA, work);
+
+  // Q2^T A Q2 = L L^T
+  if (dpotrf_6(N - M, &TIX(A, LDA, M, M), LDA, ctx->ns_chol, work) < 0)
+  {
+    PAPI_STOP("nullspace_solve");
+    return -1;
+  }
+
+  // g := Q^T f
+  memcpy(g, f, N * sizeof(double));
+  for (j = 0; j < M; ++j)
+    apply_reflector(N, V, N, j, tau[j], g);
+
+  // mu := (Q2^T A Q2)^-1 Q2^T f
+  dpotrs_6(N - M, &TIX(A, LDA, M, M), LDA, g + M);
+
+  // R c = Q1^T f - Q1^T A Q2 mu
+  double *c = x + N;
+  for (i = 0; i < M; ++i)
+  {
+    s = g[i];
+    for (r = M; r < N; ++r)
+      s -= TIX(A, LDA, r, i) * g[r];
+    c[i] = s;
+  }
+  for (i = M - 1; i >= 0; --i)
+  {
+    s = c[i];
+    for (l = i + 1; l < M; ++l)
+      s -= TIX(P, LDP, i, l) * c[l];
+    c[i] = s / TIX(P, LDP, i, i);
+  }
+
+  // lambda := Q [0; mu]
+  for (i = 0; i < M; ++i)
+    g[i] = 0.;
+  for (j = M - 1; j >= 0; --j)
+    apply_reflector(N, V, N, j, tau[j], g);
+  memcpy(x, g, N * sizeof(double));
+
+  PAPI_STOP("nullspace_solve");
+  return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "solver_context.h"
+
+/** @brief Solve the saddle point system
+ *
+ *         [ A   P ] [ lambda ]   [ f ]
+ *         [ P^T 0 ] [ c      ] = [ 0 ]
+ *
+ * where A is conditionally positive definite with respect to the columns
+ * of P. With the QR factorization P = [Q1 Q2] R, lambda = Q2 * mu and
+ * Q2^T A Q2 mu = Q2^T f is symmetric positive definite, so it is solved by
+ * Cholesky without any pivoting. c then follows from R c = Q1^T (f - A
+ * lambda).
+ *
+ * @param ctx: Workspace from nullspace_initialize_memory.
+ * @param N: Number of rows of A and P.
+ * @param M: Number of columns of P, N > M.
+ * @param A: NxN symmetric matrix (transposed layout, both triangles),
+ *           overwritten.
+ * @param LDA: The leading dimension of A.
+ * @param P: NxM matrix (transposed layout), overwritten with its QR.
+ * @param LDP: The leading dimension of P.
+ * @param f: The right hand side, N elements.
+ * @param x: Output buffer for (lambda || c), N + M elements.
+ * @return: 0 on success. <0 if the projected system is not definite.
+ */
+int nullspace_solve(struct solver_context *ctx, int N, int M, double *A,
+                    int LDA, double *P, int LDP, double *f, double *x);
+void nullspace_initialize_memory(struct solver_context *ctx, int max_n,
+                                 int max_m);
+void nullspace_free_memory(struct solver_context *ctx);
@@ -51,11 +51,12 @@ extern "C" void add_function_LU_SOLVE(lu_solve_fun_t f, char *name, int flop)
   perf_tester.add_function(f, nm, flop);
 }
 
-extern "C" int perf_test_lu_solve(int N, double *A, double *b)
+extern "C" int perf_test_lu_solve(struct solver_context *ctx, int N, double *A,
+                                  double *b)
 {
   ArgumentRestorerLU arg_restorer{N, A, b};
   int input_size = N;
   int ret = perf_tester.perf_test_all_registered(std::move(arg_restorer),
-                                                 input_size, N, A, b);
+                                                 input_size, ctx, N, A, b);
   return ret;
 }
@@ -1,10 +1,13 @@
 #pragma once
 
-typedef int (*lu_solve_fun_t)(int N, double *A, double *b);
+#include "../solver_context.h"
+
+typedef int (*lu_solve_fun_t)(struct solver_context *ctx, int N, double *A,
+                              double *b);
 
 void add_function_LU_SOLVE(lu_solve_fun_t f, char *name, int flop);
 void register_functions_LU_SOLVE();
-int perf_test_lu_solve(int N, double *A, double *b);
+int perf_test_lu_solve(struct solver_context *ctx, int N, double *A, double *b);
 
-void lu_initialize_memory(int N);
-void lu_free_memory();
+void lu_initialize_memory(struct solver_context *ctx, int N);
+void lu_free_memory(struct solver_context *ctx);
@@ -9,7 +9,8 @@ extern "C"
 #include "PerformanceTester.hpp"
 
 typedef void (*mmm_fun_t)(int M, int N, int K, double alpha, double *A, int LDA,
-                          double *B, int LDB, double beta, double *C, int LDC);
+                          double *B, int LDB, double beta, double *C, int LDC,
+                          double *work);
 
 namespace
 {
@@ -79,12 +80,12 @@ extern "C" void add_function_MMM(mmm_fun_t f, char *name, int flop)
 
 extern "C" int perf_test_mmm(int M, int N, int K, double alpha, double *A,
                              int LDA, double *B, int LDB, double beta,
-                             double *C, int LDC)
+                             double *C, int LDC, double *work)
 {
   ArgumentRestorerMMM arg_restorer{M, N,   K,    alpha, A,  LDA,
                                    B, LDB, beta, C,     LDC};
   int input_size = M;
   return perf_tester.perf_test_all_registered(std::move(arg_restorer),
                                               input_size, M, N, K, alpha, A,
-                                              LDA, B, LDB, beta, C, LDC);
+                                              LDA, B, LDB, beta, C, LDC, work);
 }
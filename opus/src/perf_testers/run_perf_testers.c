@@ -86,7 +86,7 @@ static void dump_zeros(double *A, size_t start_row, size_t start_col, size_t d,
 
   for (size_t i = 0; i < d; ++i)
   {
-    3 for (size_t j = 0; j < d; ++j)
+    for (size_t j = 0; j < d; ++j)
     {
       MAT(A, n_A, i + start_row, j + start_col) = 0.0;
     }
@@ -137,6 +137,9 @@ static void generate_random_vec(double *b, size_t n)
   }
 }
 
+// workspace of the solvers under test
+static struct solver_context perf_ctx;
+
 static void init_perf_test()
 {
   register_functions_GE_SOLVE();
@@ -145,7 +148,8 @@ static void init_perf_test()
   register_functions_MMM();
 
   // enough mem
-  lu_initialize_memory((int)pow(2, 20));
+  solver_context_init(&perf_ctx);
+  lu_initialize_memory(&perf_ctx, (int)pow(2, 20));
 }
 
 static void pre_perf_test(double **A_ge, double **A_lu, double **A_tri,
@@ -171,7 +175,7 @@ static void run_perf_tests_single(double *A_ge, double *A_lu, double *A_tri,
   // hence we run lu last.
   perf_test_ge_solve(n, A_ge, x);
   perf_test_tri_sys_solve(n, d, A_tri, x);
-  perf_test_lu_solve(n, A_lu, b);
+  perf_test_lu_solve(&perf_ctx, n, A_lu, b);
 }
 
 /*
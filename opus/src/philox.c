@@ -0,0 +1,110 @@
+#include "philox.h"
+
+#include <immintrin.h>
+#include <string.h>
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+void philox4x32_10(struct philox_key key, uint32_t const ctr[4],
+                   uint32_t out[4])
+{
+  uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+  uint32_t k0 = key.k0, k1 = key.k1;
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++)
+  {
+    uint64_t p0 = (uint64_t)PHILOX_M0 * x0;
+    uint64_t p1 = (uint64_t)PHILOX_M1 * x2;
+    uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+    uint32_t y1 = (uint32_t)p1;
+    uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+    uint32_t y3 = (uint32_t)p0;
+    x0 = y0, x1 = y1, x2 = y2, x3 = y3;
+    k0 += PHILOX_W0, k1 += PHILOX_W1;
+  }
+
+  out[0] = x0, out[1] = x1, out[2] = x2, out[3] = x3;
+}
+
+// 32 x 32 -> 64 bits products of the eight lanes of a with m
+static inline void mulhilo_8(__m256i a, __m256i m, __m256i *lo, __m256i *hi)
+{
+  // lanes 0, 2, 4, 6 and 1, 3, 5, 7
+  __m256i even = _mm256_mul_epu32(a, m);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// u32 -> double in [0, 1)
+static inline void uniform_8(__m256i x, double *out)
+{
+  __m256i sign = _mm256_set1_epi32(0x80000000);
+  __m256d off = _mm256_set1_pd(2147483648.);
+  __m256d scale = _mm256_set1_pd(1. / 4294967296.);
+
+  // flip the sign bit to convert as signed, then shift back
+  x = _mm256_xor_si256(x, sign);
+  __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(x));
+  __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1));
+  _mm256_storeu_pd(out, _mm256_mul_pd(_mm256_add_pd(lo, off), scale));
+  _mm256_storeu_pd(out + 4, _mm256_mul_pd(_mm256_add_pd(hi, off), scale));
+}
+
+// Blocks 8 g .. 8 g + 7 to out[0 : 32]
+static inline void philox_uniform_32(struct philox_key key, uint32_t g,
+                                     __m256i c1, __m256i c2, __m256i c3,
+                                     double *out)
+{
+  __m256i m0 = _mm256_set1_epi32(PHILOX_M0);
+  __m256i m1 = _mm256_set1_epi32(PHILOX_M1);
+  __m256i k0 = _mm256_set1_epi32(key.k0);
+  __m256i k1 = _mm256_set1_epi32(key.k1);
+  __m256i w0 = _mm256_set1_epi32(PHILOX_W0);
+  __m256i w1 = _mm256_set1_epi32(PHILOX_W1);
+
+  __m256i x0 = _mm256_add_epi32(_mm256_set1_epi32(8 * g),
+                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i x1 = c1, x2 = c2, x3 = c3;
+  __m256i lo0, hi0, lo1, hi1;
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++)
+  {
+    mulhilo_8(x0, m0, &lo0, &hi0);
+    mulhilo_8(x2, m1, &lo1, &hi1);
+    x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), k0);
+    x1 = lo1;
+    x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), k1);
+    x3 = lo0;
+    k0 = _mm256_add_epi32(k0, w0);
+    k1 = _mm256_add_epi32(k1, w1);
+  }
+
+  uniform_8(x0, out);
+  uniform_8(x1, out + 8);
+  uniform_8(x2, out + 16);
+  uniform_8(x3, out + 24);
+}
+
+void philox_uniform(struct philox_key key, uint32_t c1, uint32_t c2,
+                    uint32_t c3, size_t n, double *out)
+{
+  __m256i v1 = _mm256_set1_epi32(c1);
+  __m256i v2 = _mm256_set1_epi32(c2);
+  __m256i v3 = _mm256_set1_epi32(c3);
+
+  uint32_t g = 0;
+  for (; 32 * (size_t)(g + 1) <= n; g++)
+    philox_uniform_32(key, g, v1, v2, v3, out + 32 * g);
+
+  if (32 * (size_t)g < n)
+  {
+    double tail[32];
+    philox_uniform_32(key, g, v1, v2, v3, tail);
+    memcpy(out + 32 * g, tail, (n - 32 * (size_t)g) * sizeof(double));
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Philox4x32-10 counter based generator (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3", SC'11)
+ *
+ * Block b of the stream (c1, c2, c3) is the encryption of the counter
+ * (b, c1, c2, c3) under the key, so any number of the stream is computed
+ * independently of the others: no state, no sequential dependency, the
+ * same values whatever the number of threads.
+ */
+
+struct philox_key
+{
+  uint32_t k0;
+  uint32_t k1;
+};
+
+/** @brief Fill out with the n first numbers of the stream (c1, c2, c3),
+ *         uniform in [0, 1) with a resolution of 2^-32.
+ *
+ * Eight blocks are encrypted at once in AVX2 lanes. Numbers 32 g .. 32 g +
+ * 31 are word k of block 8 g + m at 32 g + 8 k + m.
+ */
+void philox_uniform(struct philox_key key, uint32_t c1, uint32_t c2,
+                    uint32_t c3, size_t n, double *out);
+
+// Reference implementation: the four words of one block
+void philox4x32_10(struct philox_key key, uint32_t const ctr[4],
+                   uint32_t out[4]);
@@ -13,6 +13,7 @@
 
 #include "steps/steps.h"
 
+#include "threads.h"
 #include "timer.h"
 
 #if DISTINCTIVENESS_CHECK_TYPE == 2
@@ -38,8 +39,8 @@ struct pso_data_constant_inertia *alloc_pso_data_constant_inertia()
 void random_number_generation(struct pso_data_constant_inertia *pso)
 {
   // Step 3
-  pso->step3_rands =
-      malloc(pso->population_size * pso->dimensions * sizeof(double));
+  pso->step3_rands = arena_alloc(
+      &pso->arena, pso->population_size * pso->dimensions * sizeof(double));
   for (int i = 0; i < pso->population_size; i++)
   {
     for (int k = 0; k < pso->dimensions; k++)
@@ -49,17 +50,11 @@ void random_number_generation(struct pso_data_constant_inertia *pso)
     }
   }
 
-  // Step 6
-  size_t step6_rands_size = pso->time_max * 2 * pso->population_size *
-                            pso->n_trials * pso->dimensions;
-  size_t step6_rands_mem_size_a32 =
-      (step6_rands_size * sizeof(double) + 31) & -32;
-  pso->step6_rands_array_start = aligned_alloc(32, step6_rands_mem_size_a32);
-
-  for (size_t i = 0; i < step6_rands_size; i++)
-  {
-    pso->step6_rands_array_start[i] = (double)rand() / RAND_MAX;
-  }
+  // Step 6: counter based, drawn per trial from this key
+  pso->rng_key.k0 = rand();
+  pso->rng_key.k1 = rand();
+  pso->step6_rands =
+      arena_alloc(&pso->arena, 2 * pso->dimensions * sizeof(double));
 }
 
 void pso_constant_inertia_init(struct pso_data_constant_inertia *pso,
@@ -82,15 +77,20 @@ void pso_constant_inertia_init(struct pso_data_constant_inertia *pso,
 
   pso->time = 0;
 
-  pso->x =
-      (double *)malloc(pso->population_size * pso->dimensions * sizeof(double));
-  pso->x_eval = malloc(pso->population_size * sizeof(double));
+  // every buffer of fixed size comes from the arena, see pso_destroy
+  arena_init(&pso->arena);
+  struct arena *arena = &pso->arena;
+  size_t pop_vecs_size =
+      pso->population_size * pso->dimensions * sizeof(double);
+
+  pso->x = arena_alloc(arena, pop_vecs_size);
+  pso->x_eval = arena_alloc(arena, pso->population_size * sizeof(double));
 
-  pso->v = malloc(pso->population_size * pso->dimensions * sizeof(double));
+  pso->v = arena_alloc(arena, pop_vecs_size);
 
-  pso->y = malloc(pso->population_size * pso->dimensions * sizeof(double));
+  pso->y = arena_alloc(arena, pop_vecs_size);
 
-  pso->y_eval = malloc(pso->population_size * sizeof(double *));
+  pso->y_eval = arena_alloc(arena, pso->population_size * sizeof(double));
 
   // yhat will be a pointer in another array
   pso->y_hat = NULL;
@@ -98,19 +98,37 @@ void pso_constant_inertia_init(struct pso_data_constant_inertia *pso,
   // size of one vector, rounded up to be 32B aligned
   size_t size_of_one_vec_32 = (((pso->dimensions * sizeof(double)) + 31) & -32);
 
-  pso->v_trial = aligned_alloc(32, size_of_one_vec_32);
-  pso->x_trial = aligned_alloc(32, size_of_one_vec_32);
+  pso->v_trial = arena_alloc(arena, size_of_one_vec_32);
+  pso->x_trial = arena_alloc(arena, size_of_one_vec_32);
 
-  pso->v_trial_best = malloc(pso->dimensions * sizeof(double));
-  pso->x_trial_best = malloc(pso->dimensions * sizeof(double));
+  pso->v_trial_best = arena_alloc(arena, pso->dimensions * sizeof(double));
+  pso->x_trial_best = arena_alloc(arena, pso->dimensions * sizeof(double));
 
-  pso->x_local = malloc(pso->dimensions * sizeof(double));
+  size_t n_trial_batch = pso->population_size * pso->n_trials;
+  pso->x_trial_batch =
+      arena_alloc(arena, n_trial_batch * pso->dimensions * sizeof(double));
+  pso->v_trial_batch =
+      arena_alloc(arena, n_trial_batch * pso->dimensions * sizeof(double));
+  pso->x_trial_batch_seval = arena_alloc(arena, n_trial_batch * sizeof(double));
 
-  pso->bound_low = (double *)aligned_alloc(32, size_of_one_vec_32);
-  pso->bound_high = (double *)aligned_alloc(32, size_of_one_vec_32);
+  pso->trial_scratch_ld = size_of_one_vec_32 / sizeof(double);
+  pso->trial_scratch =
+      arena_alloc(arena, omp_get_max_threads() * 6 * size_of_one_vec_32);
 
-  pso->vmin = (double *)aligned_alloc(32, size_of_one_vec_32);
-  pso->vmax = (double *)aligned_alloc(32, size_of_one_vec_32);
+  pso->x_local = arena_alloc(arena, LOCAL_REFINEMENT_STARTS *
+                                         pso->dimensions * sizeof(double));
+  pso->x_local_starts = 0;
+  pso->x_local_n = 0;
+  pso->local_refinement_work =
+      arena_alloc(arena, LOCAL_REFINEMENT_STARTS *
+                             LOCAL_OPTIMIZATION_WORK_SIZE(pso->dimensions) *
+                             sizeof(double));
+
+  pso->bound_low = arena_alloc(arena, size_of_one_vec_32);
+  pso->bound_high = arena_alloc(arena, size_of_one_vec_32);
+
+  pso->vmin = arena_alloc(arena, size_of_one_vec_32);
+  pso->vmax = arena_alloc(arena, size_of_one_vec_32);
 
   for (int j = 0; j < dimensions; j++)
   {
@@ -121,42 +139,51 @@ void pso_constant_inertia_init(struct pso_data_constant_inertia *pso,
   // pso->population_size particles per iterations, and 1 for the local
   // minimizer
   // + initial space filling design
-  size_t x_distinct_max_nb =
-      pso->time_max * (pso->population_size + 1) + sfd_size;
-  // printf("x_ds_max = %zu\n", x_distinct_max_nb);
-  pso->x_distinct =
-      malloc(x_distinct_max_nb * pso->dimensions * sizeof(double));
+  // This is only what the first iteration needs, x_distinct and the
+  // surrogate buffers grow with the number of distinct points (see
+  // reserve_distincts).
+  size_t x_distinct_cap = sfd_size + pso->population_size + 1;
+  pso->x_distinct = malloc(x_distinct_cap * pso->dimensions * sizeof(double));
   pso->x_distinct_idx_of_last_batch = 0;
   pso->x_distinct_s = 0;
+  pso->x_distinct_cap = x_distinct_cap;
 
-  pso->x_distinct_eval = malloc(x_distinct_max_nb * sizeof(double));
+  pso->x_distinct_eval = malloc(x_distinct_cap * sizeof(double));
+  pso->x_distinct_norm2 = malloc(x_distinct_cap * sizeof(double));
+  eval_cache_init(&pso->eval_cache, x_distinct_cap,
+                  MAX(sfd_size, (size_t)pso->population_size));
 
 #if DISTINCTIVENESS_CHECK_TYPE == 0
   // Unconditionnal accept ; nothing to allocate
 #elif DISTINCTIVENESS_CHECK_TYPE == 1
-  // Naive distance calculation ; nothing to allocate
+  // Naive distance calculation ; the distances of a population, grows with
+  // x_distinct
+  pso->batch_dist2 =
+      malloc(x_distinct_cap * pso->population_size * sizeof(double));
 #elif DISTINCTIVENESS_CHECK_TYPE == 2
   // Bloom filter
-  pso->bloom = malloc(sizeof(struct rounding_bloom));
-  int bloom_entries = pso->time_max * pso->population_size;
-  if (bloom_entries < 1000)
-    bloom_entries = 1000;
+  pso->bloom = arena_alloc(arena, sizeof(struct rounding_bloom));
+  pso->distinct_found = arena_alloc(arena, pso->population_size * sizeof(int));
+  // grows with x_distinct
+  int bloom_entries = x_distinct_cap;
   double bloom_false_pos_rate = 0.01;
   double bloom_rounding_eps = min_dist;
   rounding_bloom_init(pso->bloom, bloom_entries, bloom_false_pos_rate,
                       bloom_rounding_eps, dimensions, bounds_low);
+#elif DISTINCTIVENESS_CHECK_TYPE == 3
+  // Grid hash, grows with x_distinct
+  grid_hash_init(&pso->grid, dimensions, min_dist, x_distinct_cap);
 #endif
 
   // the size of phi is the total number of _distinct_ points where
   // f has been evaluated
-  // max: pop_size * time
-  //  TODO: add the refinement points + 1 * time
-  //        add the space filling design +?
-  size_t max_n_phi = x_distinct_max_nb;
+  size_t max_n_phi = x_distinct_cap;
   size_t n_P = pso->dimensions + 1;
-  prealloc_fit_surrogate(max_n_phi, n_P);
+  solver_context_init(&pso->ctx);
+  prealloc_fit_surrogate(&pso->ctx, max_n_phi, n_P);
+  surrogate_eval_initialize_memory(&pso->ctx, pso->dimensions);
 
-  // alloc maximum possible size: max_n_phi for lambda and d+1 for P
+  // max_n_phi for lambda and d+1 for P
   size_t lambda_p_s = max_n_phi + (pso->dimensions + 1);
   pso->lambda_p = malloc(lambda_p_s * sizeof(double));
 
@@ -212,6 +239,26 @@ void pso_constant_inertia_first_steps(struct pso_data_constant_inertia *pso,
 #endif
 }
 
+void pso_destroy(struct pso_data_constant_inertia *pso)
+{
+#if DISTINCTIVENESS_CHECK_TYPE == 1
+  free(pso->batch_dist2);
+#elif DISTINCTIVENESS_CHECK_TYPE == 2
+  rounding_bloom_free(pso->bloom);
+#elif DISTINCTIVENESS_CHECK_TYPE == 3
+  grid_hash_free(&pso->grid);
+#endif
+  free(pso->x_distinct);
+  free(pso->x_distinct_eval);
+  free(pso->x_distinct_norm2);
+  // unless it points to the solution of the LU fits in the context
+  if (pso->lambda_p != pso->ctx.b)
+    free(pso->lambda_p);
+  eval_cache_free(&pso->eval_cache);
+  solver_context_free(&pso->ctx);
+  arena_free(&pso->arena);
+}
+
 bool pso_constant_inertia_loop(struct pso_data_constant_inertia *pso)
 {
 #if ENABLE_TIMER == 1
@@ -317,4 +364,9 @@ void run_pso(blackbox_fun f, double inertia, double social, double cognition,
 #if ENABLE_TIMER == 1
   timer_print_statistics(pso.time_max);
 #endif
+
+  printf("%zu evaluations, %zu answered by the cache\n",
+         pso.eval_cache.hits + pso.eval_cache.misses, pso.eval_cache.hits);
+
+  pso_destroy(&pso);
 }
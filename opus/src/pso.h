@@ -3,6 +3,12 @@
 #include <stdbool.h>
 #include <sys/types.h>
 
+#include "arena.h"
+#include "eval_cache.h"
+#include "grid_hash.h"
+#include "philox.h"
+#include "solver_context.h"
+
 typedef double (*blackbox_fun)(double const *const);
 
 /*
@@ -10,13 +16,17 @@ typedef double (*blackbox_fun)(double const *const);
  * 0 -> no check
  * 1 -> naive pairwise distance computations
  * 2 -> rounding bloom filter
+ * 3 -> hashed grid, exact comparisons with the neighbouring points only
  *
- * In high dimension, the bloom filter becomes very slow.
+ * The bloom filter is approximate (see rounding_bloom.h), but its cost
+ * does not grow with the number of distinct points.
  * Without checks, if non-distinct particles make the
  * eliminitation fail (repeated lines).
  *
  */
+#ifndef DISTINCTIVENESS_CHECK_TYPE
 #define DISTINCTIVENESS_CHECK_TYPE 1
+#endif
 
 // PSO_X : pso::pso, i:int -> x_i :double*
 #define PSO_X(pso, i) ((pso)->x + (i) * (pso)->dimensions)
@@ -65,8 +75,25 @@ struct pso_data_constant_inertia
   double *x_trial_best;
   double *v_trial_best;
 
-  // Used in steps 10 and 11 in local refinement
+  // all population_size * n_trials trials of step 6, scored in one batch
+  double *x_trial_batch;
+  double *v_trial_batch;
+  double *x_trial_batch_seval;
+
+  // x_trial, v_trial, x_trial_best, v_trial_best and the random numbers (2
+  // rows) of every thread of the parallel step 6, each trial_scratch_ld
+  // doubles and 32 bytes aligned
+  double *trial_scratch;
+  size_t trial_scratch_ld;
+
+  // Used in steps 10 and 11 in local refinement, LOCAL_REFINEMENT_STARTS
+  // points: the x_local_starts minimizers of step 10, the x_local_n of them
+  // to evaluate after step11_ask
   double *x_local;
+  int x_local_starts;
+  size_t x_local_n;
+  // LOCAL_OPTIMIZATION_WORK_SIZE(dimensions) doubles per start for step 10
+  double *local_refinement_work;
 
   double *bound_low;
   double *bound_high;
@@ -79,12 +106,27 @@ struct pso_data_constant_inertia
   size_t x_distinct_idx_of_last_batch;
   // total size of x_distinct_s
   size_t x_distinct_s;
+  // number of points x_distinct, x_distinct_eval and x_distinct_norm2 can
+  // hold
+  size_t x_distinct_cap;
 
   // fonction evaluation at x_distinct[k]
   double *x_distinct_eval;
-
-#if DISTINCTIVENESS_CHECK_TYPE == 2
+  // squared norm of x_distinct[k], for the batched surrogate evaluation
+  double *x_distinct_norm2;
+  // x_distinct by bit pattern, to skip evaluating a point twice
+  struct eval_cache eval_cache;
+
+#if DISTINCTIVENESS_CHECK_TYPE == 1
+  // squared distances of a population to x_distinct, population_size rows
+  // of x_distinct_cap
+  double *batch_dist2;
+#elif DISTINCTIVENESS_CHECK_TYPE == 2
   struct rounding_bloom *bloom;
+  // results of the batched check of a population
+  int *distinct_found;
+#elif DISTINCTIVENESS_CHECK_TYPE == 3
+  struct grid_hash grid;
 #endif
 
   // parameters of the surrogate
@@ -92,12 +134,35 @@ struct pso_data_constant_inertia
   // (as this is the format of the output vector of fit_surrogate)
   double *lambda_p;
 
+  // buffers of fit_surrogate, the system solvers and the batched surrogate
+  // evaluation, owned by this optimization
+  struct solver_context ctx;
+
+  // owns every buffer of fixed size, the ones above that grow with
+  // x_distinct are on the heap
+  struct arena arena;
+
+  // ask/tell driver: the step that consumes the pending batch of pending_n
+  // points and their evaluations received so far
+  int phase;
+  size_t pending_n;
+  size_t pending_told_n;
+  double *pending_eval;
+  // the points of the batch missing from the evaluation cache, the ones
+  // handed out by pso_ask, and their rows in the batch
+  double *pending_ask_x;
+  size_t *pending_ask_map;
+  size_t pending_ask_n;
+  unsigned char *pending_told;
+  double *sfd;
+  size_t sfd_size;
+
   // random numbers precomputed
-  double *step3_rands;             // population_size * dimensions
-  double *step6_rands_array_start; // 2 * time_max * population_size * n_trails
-                                   // * dimensions
-  double *step6_rands; // current batch of 2 * population_size * n_trails *
-                       // dimensions
+  double *step3_rands; // population_size * dimensions
+  // key of the counter based generator of the step 6 random numbers
+  struct philox_key rng_key;
+  // the 2 * dimensions random numbers of the current trial of step 6
+  double *step6_rands;
 
   double inertia;
   double social;
@@ -138,3 +203,5 @@ void pso_constant_inertia_first_steps(struct pso_data_constant_inertia *pso,
                                       size_t sfd_size,
                                       double *space_filling_design);
 bool pso_constant_inertia_loop(struct pso_data_constant_inertia *pso);
+// Release everything pso_constant_inertia_init allocated, but not pso itself
+void pso_destroy(struct pso_data_constant_inertia *pso);
@@ -1,12 +1,12 @@
 #include "rounding_bloom.h"
 
-#include <assert.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "helpers.h"
+#include "philox.h"
 
 #define DEBUG_BLOOM 0
 
@@ -16,72 +16,105 @@ struct rounding_bloom *rounding_bloom_alloc()
   return malloc(sizeof(struct rounding_bloom));
 }
 
+#define ROUNDING_BLOOM_HASHES                                                  \
+  (ROUNDING_BLOOM_TABLES * ROUNDING_BLOOM_PROJECTIONS)
+// keys probed per table
+#define ROUNDING_BLOOM_PROBES (1 << ROUNDING_BLOOM_PROJECTIONS)
+// keys probed per point, the first probe of each table is the key added
+#define ROUNDING_BLOOM_KEYS (ROUNDING_BLOOM_TABLES * ROUNDING_BLOOM_PROBES)
+// a key: the table index, then the bins of its projections
+#define ROUNDING_BLOOM_KEY_LEN (ROUNDING_BLOOM_PROJECTIONS + 1)
+
 int rounding_bloom_init(struct rounding_bloom *bloom, int entries, double error,
                         double epsilon, int dims, double const *lower_bound)
 {
   int ret;
-  if ((ret = bloom_init(&bloom->bloom, entries, error) > 0))
+  // every point adds one key per table, and a check makes
+  // ROUNDING_BLOOM_KEYS probes
+  if ((ret = blocked_bloom_init(&bloom->bloom,
+                                (size_t)entries * ROUNDING_BLOOM_TABLES,
+                                error / ROUNDING_BLOOM_KEYS) > 0))
   {
     return ret;
   }
+  bloom->batch_keys = NULL;
+  bloom->batch_hashes = NULL;
+  bloom->batch_cap = 0;
 
   bloom->dims = dims;
   bloom->lower_bound = malloc(dims * sizeof(double));
   for (int i = 0; i < dims; i++)
   {
-    // Keep some space for the dual grid
-    bloom->lower_bound[i] = lower_bound[i] - epsilon;
+    bloom->lower_bound[i] = lower_bound[i];
+  }
+
+  // gaussian directions by Box-Muller, and uniform offsets
+  size_t n_rands = 2 * (ROUNDING_BLOOM_HASHES * dims + ROUNDING_BLOOM_HASHES);
+  double *rands = malloc(n_rands * sizeof(double));
+  struct philox_key key = {0x9747b28c, 0x5bd1e995};
+  philox_uniform(key, 0, 0, 0, n_rands, rands);
+
+  double inv_w = 1. / (ROUNDING_BLOOM_WIDTH * epsilon);
+  bloom->projections = malloc(ROUNDING_BLOOM_HASHES * dims * sizeof(double));
+  bloom->offsets = malloc(ROUNDING_BLOOM_HASHES * sizeof(double));
+  for (int i = 0; i < ROUNDING_BLOOM_HASHES * dims; i++)
+  {
+    double r = sqrt(-2. * log(1. - rands[2 * i]));
+    bloom->projections[i] = r * cos(2. * M_PI * rands[2 * i + 1]) * inv_w;
+  }
+  for (int j = 0; j < ROUNDING_BLOOM_HASHES; j++)
+  {
+    bloom->offsets[j] = rands[2 * ROUNDING_BLOOM_HASHES * dims + j];
   }
+  free(rands);
 
   bloom->epsilon = epsilon;
   return 0;
 }
 
-int rounding_bloom_check_add(struct rounding_bloom *bloom, int dims,
-                             double const *const x, int add)
+// The ROUNDING_BLOOM_KEYS probe keys of x
+static void rounding_bloom_keys(struct rounding_bloom const *bloom, int dims,
+                                double const *const x, int64_t *keys)
 {
-  int ret = 0;
-  uint64_t *bin_id = malloc(dims * sizeof(uint64_t));
-  uint64_t *dual_bin_id = malloc(dims * sizeof(uint64_t));
-
-  for (int i = 0; i < dims; i++)
+  for (int t = 0; t < ROUNDING_BLOOM_TABLES; t++)
   {
-    assert(x[i] >= bloom->lower_bound[i]);
-    double y = x[i] - bloom->lower_bound[i];
-    double k = y / bloom->epsilon;
-    assert(k < (double)UINT64_MAX);
-    bin_id[i] = floor(k);
-    dual_bin_id[i] = floor(k - 0.5);
-  }
+    int64_t bin_id[ROUNDING_BLOOM_PROJECTIONS];
+    int64_t step[ROUNDING_BLOOM_PROJECTIONS];
 
-  uint64_t max_off = 1 << dims;
-
-  uint64_t *neighbor_dual_bin_id = malloc(dims * sizeof(uint64_t));
-
-#if DEBUG_BLOOM
-  print_vectord(x, dims, "x");
-  print_vectoru64(bin_id, dims, "bin_id");
-  print_vectoru64(dual_bin_id, dims, "dual_bin_id");
-#endif
-
-  for (uint64_t off = 0; off < max_off; off++)
-  {
-    for (int i = 0; i < dims; i++)
+    for (int j = 0; j < ROUNDING_BLOOM_PROJECTIONS; j++)
     {
-      neighbor_dual_bin_id[i] = dual_bin_id[i] + ((off >> i) & 1);
+      int h = t * ROUNDING_BLOOM_PROJECTIONS + j;
+      double const *a = bloom->projections + h * dims;
+      double k = bloom->offsets[h];
+      for (int i = 0; i < dims; i++)
+      {
+        k += a[i] * (x[i] - bloom->lower_bound[i]);
+      }
+      double bin = floor(k);
+      bin_id[j] = (int64_t)bin;
+      // the neighbor bin on the side of the closest edge
+      step[j] = k - bin < 0.5 ? -1 : 1;
     }
 
-    if (bloom_check(&bloom->bloom, (char *)neighbor_dual_bin_id,
-                    dims * sizeof(uint64_t)))
+    for (int off = 0; off < ROUNDING_BLOOM_PROBES; off++)
     {
-      ret = 1;
-#if DEBUG_BLOOM
-      printf("Found collision with\n");
-      print_vectoru64(neighbor_dual_bin_id, dims, "neighbor_dual_bin_id");
-#endif
-      break;
+      int64_t *neighbor_bin_id =
+          keys + (t * ROUNDING_BLOOM_PROBES + off) * ROUNDING_BLOOM_KEY_LEN;
+      neighbor_bin_id[0] = t;
+      for (int j = 0; j < ROUNDING_BLOOM_PROJECTIONS; j++)
+      {
+        neighbor_bin_id[j + 1] = bin_id[j] + ((off >> j) & 1) * step[j];
+      }
     }
   }
+}
+
+// Check the hashed probe keys of a point, add its keys if none is found
+static int rounding_bloom_check_add_hashes(struct rounding_bloom *bloom,
+                                           uint32_t const *hashes, int add)
+{
+  int ret =
+      blocked_bloom_check_any(&bloom->bloom, hashes, ROUNDING_BLOOM_KEYS);
 
   if (add && ret == 0)
   {
@@ -89,15 +122,66 @@ int rounding_bloom_check_add(struct rounding_bloom *bloom, int dims,
     printf("No collision. Adding to bloom filter.\n");
 #endif
 
-    bloom_add(&bloom->bloom, (char *)bin_id, sizeof(uint64_t) * dims);
+    for (int t = 0; t < ROUNDING_BLOOM_TABLES; t++)
+    {
+      blocked_bloom_add_hash(&bloom->bloom,
+                             hashes[t * ROUNDING_BLOOM_PROBES]);
+    }
   }
 
-  free(neighbor_dual_bin_id);
-  free(dual_bin_id);
-  free(bin_id);
   return ret;
 }
 
+int rounding_bloom_check_add(struct rounding_bloom *bloom, int dims,
+                             double const *const x, int add)
+{
+  int64_t keys[ROUNDING_BLOOM_KEYS * ROUNDING_BLOOM_KEY_LEN];
+  uint32_t hashes[ROUNDING_BLOOM_KEYS];
+
+#if DEBUG_BLOOM
+  print_vectord(x, dims, "x");
+#endif
+
+  rounding_bloom_keys(bloom, dims, x, keys);
+  blocked_bloom_hash(keys, ROUNDING_BLOOM_KEY_LEN * sizeof(int64_t),
+                     ROUNDING_BLOOM_KEYS, hashes);
+  return rounding_bloom_check_add_hashes(bloom, hashes, add);
+}
+
+void rounding_bloom_check_add_batch(struct rounding_bloom *bloom, int dims,
+                                    double const *const xs, size_t n, int add,
+                                    int *found)
+{
+  if (n > bloom->batch_cap)
+  {
+    bloom->batch_cap = n;
+    bloom->batch_keys =
+        realloc(bloom->batch_keys, n * ROUNDING_BLOOM_KEYS *
+                                       ROUNDING_BLOOM_KEY_LEN * sizeof(int64_t));
+    bloom->batch_hashes = realloc(
+        bloom->batch_hashes, n * ROUNDING_BLOOM_KEYS * sizeof(uint32_t));
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    rounding_bloom_keys(bloom, dims, xs + i * dims,
+                        bloom->batch_keys +
+                            i * ROUNDING_BLOOM_KEYS * ROUNDING_BLOOM_KEY_LEN);
+  }
+  blocked_bloom_hash(bloom->batch_keys,
+                     ROUNDING_BLOOM_KEY_LEN * sizeof(int64_t),
+                     n * ROUNDING_BLOOM_KEYS, bloom->batch_hashes);
+  blocked_bloom_prefetch(&bloom->bloom, bloom->batch_hashes,
+                         n * ROUNDING_BLOOM_KEYS);
+
+  // in order, x_i is also checked against the points added before it
+  for (size_t i = 0; i < n; i++)
+  {
+    found[i] = rounding_bloom_check_add_hashes(
+        bloom, bloom->batch_hashes + i * ROUNDING_BLOOM_KEYS, add);
+  }
+}
+
 int rounding_bloom_check(struct rounding_bloom *bloom, int dims,
                          double *const x)
 {
@@ -106,12 +190,16 @@ int rounding_bloom_check(struct rounding_bloom *bloom, int dims,
 
 void rounding_bloom_print(struct rounding_bloom *bloom)
 {
-  bloom_print(&bloom->bloom);
+  blocked_bloom_print(&bloom->bloom);
   printf(" ->eps = %f\n", bloom->epsilon);
 }
 
 void rounding_bloom_free(struct rounding_bloom *bloom)
 {
   free(bloom->lower_bound);
-  bloom_free(&bloom->bloom);
+  free(bloom->projections);
+  free(bloom->offsets);
+  free(bloom->batch_keys);
+  free(bloom->batch_hashes);
+  blocked_bloom_free(&bloom->bloom);
 }
@@ -0,0 +1,62 @@
+#include "solver_context.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "blas/dgemm.h"
+#include "blas/sgemm.h"
+#include "krylov_solve.h"
+#include "ldlt_solve.h"
+#include "lu_solve.h"
+#include "nullspace_solve.h"
+#include "steps/fit_surrogate.h"
+#include "steps/surrogate_eval.h"
+
+void solver_context_init(struct solver_context *ctx)
+{
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+void solver_context_free(struct solver_context *ctx)
+{
+  free_fit_surrogate(ctx);
+  surrogate_eval_free_memory(ctx);
+  lu_free_memory(ctx);
+  ldlt_free_memory(ctx);
+  nullspace_free_memory(ctx);
+  krylov_free_memory(ctx);
+
+  dgemm_free_work(ctx->dgemm_work);
+  free(ctx->sgemm_work);
+  solver_context_init(ctx);
+}
+
+struct solver_context *solver_context_alloc()
+{
+  struct solver_context *ctx = malloc(sizeof(*ctx));
+  if (ctx)
+    solver_context_init(ctx);
+  return ctx;
+}
+
+void solver_context_destroy(struct solver_context *ctx)
+{
+  if (!ctx)
+    return;
+  solver_context_free(ctx);
+  free(ctx);
+}
+
+double *solver_context_dgemm_work(struct solver_context *ctx)
+{
+  if (!ctx->dgemm_work)
+    ctx->dgemm_work = dgemm_alloc_work();
+  return ctx->dgemm_work;
+}
+
+float *solver_context_sgemm_work(struct solver_context *ctx)
+{
+  if (!ctx->sgemm_work)
+    ctx->sgemm_work = sgemm_alloc_work();
+  return ctx->sgemm_work;
+}
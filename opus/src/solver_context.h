@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Workspace of one optimization: the buffers of the surrogate fit, of the
+ * linear system solvers and of the BLAS kernels they call, along with the
+ * little state carried from one fit to the next.
+ *
+ * Each group of members belongs to the module named above it, which
+ * allocates it in its prealloc / *_initialize_memory function and releases
+ * it in its *_free_memory function. Nothing in those modules is process
+ * wide, so independent optimizations can run concurrently as long as each
+ * has its own context.
+ */
+struct solver_context
+{
+  // steps/fit_surrogate.c
+  // is either [A | b] for GE and BLOCK_TRI or [A] for LU
+  double *Ab;
+  double *P;
+  // if using LU
+  double *b;
+  // Phi(p, q) for p < q, filled by check_if_distinct
+  double *phi_cache;
+  // leading dimension of the square phi cache of versions 2 to 4, 0 when
+  // packed
+  size_t phi_cache_ld;
+  // number of distinct points the buffers are sized for
+  size_t max_n_phi;
+  // Incremental factorizations: pivots, leading dimension of the factors in
+  // Ab and the number of distinct points they cover
+  int *ipiv;
+  size_t factored_ld;
+  size_t factored_n_phi;
+
+  // steps/surrogate_eval.c: 2 X^T of a block of points, their norms and the
+  // distance tile
+  double *seval_xt;
+  double *seval_xn;
+  double *seval_g;
+
+  // lu_solve.c
+  int *lu_ipiv;
+  // Mixed precision: float copy of A, the iterate, the residual, |A| |x|
+  // and the float correction, allocated by lu_solve_8 for up to lu_mixed_n
+  // unknowns.
+  float *lu_sa;
+  double *lu_x;
+  double *lu_r;
+  double *lu_ax;
+  float *lu_sr;
+  int lu_mixed_n;
+  // Smallest N for which the refinement failed since lu_initialize_memory.
+  // The surrogate systems only get worse conditioned as they grow, so
+  // larger ones go straight to lu_solve_6.
+  int lu_mixed_fallback_n;
+  // Largest magnitude of the entries factored by lu_factor and
+  // lu_factor_border so far
+  double lu_amax;
+  // lu_solve_9: a dgemm packing workspace per thread, lu_task_work_size
+  // doubles in all
+  double *lu_task_work;
+  size_t lu_task_work_size;
+
+  // ldlt_solve.c: pivots and the panel workspace of dsytrf
+  int *ldlt_ipiv;
+  double *ldlt_w;
+  // Largest magnitude of the entries factored by ldlt_factor and
+  // ldlt_factor_border so far
+  double ldlt_amax;
+
+  // nullspace_solve.c
+  // Householder vectors and block reflector I - V T V^T of P
+  double *ns_tau;
+  double *ns_t;
+  double *ns_v;
+  double *ns_vt;
+  // A V and the symmetric rank-2M update factor W
+  double *ns_x;
+  double *ns_w;
+  double *ns_wt;
+  // V^T W and T^T V^T W
+  double *ns_mm;
+  // Cholesky panel workspace
+  double *ns_chol;
+  double *ns_g;
+
+  // krylov_solve.c
+  // Residual r = A lambda - f, preconditioned residual g, direction d, A d
+  double *krylov_r;
+  double *krylov_g;
+  double *krylov_d;
+  double *krylov_q;
+  // Preconditioner: D^-1 and the Cholesky factor of P^T D^-1 P
+  double *krylov_dinv;
+  double *krylov_s;
+  // Preconditioned residual of the last solve relative to the right hand
+  // side
+  double krylov_residual;
+
+  // Packing workspaces of dgemm and sgemm, shared by all of the above and
+  // allocated by whichever needs them first.
+  double *dgemm_work;
+  float *sgemm_work;
+};
+
+void solver_context_init(struct solver_context *ctx);
+// Release every buffer of every module
+void solver_context_free(struct solver_context *ctx);
+
+// Heap allocated context for callers that cannot embed the struct, e.g. the
+// Julia FFI tests. NULL if out of memory.
+struct solver_context *solver_context_alloc();
+void solver_context_destroy(struct solver_context *ctx);
+
+double *solver_context_dgemm_work(struct solver_context *ctx);
+float *solver_context_sgemm_work(struct solver_context *ctx);
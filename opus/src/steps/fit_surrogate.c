@@ -15,10 +15,25 @@
 int fit_surrogate_6_GE(struct pso_data_constant_inertia *pso);
 int fit_surrogate_6_LU(struct pso_data_constant_inertia *pso);
 int fit_surrogate_6_BLOCK_TRI(struct pso_data_constant_inertia *pso);
-
-int prealloc_fit_surrogate_6_GE(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_6_LU(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_6_BLOCK_TRI(size_t max_n_phi, size_t n_P);
+int fit_surrogate_6_LU_incremental(struct pso_data_constant_inertia *pso);
+int fit_surrogate_6_LDLT(struct pso_data_constant_inertia *pso);
+int fit_surrogate_6_NULLSPACE(struct pso_data_constant_inertia *pso);
+int fit_surrogate_6_KRYLOV(struct pso_data_constant_inertia *pso);
+
+int prealloc_fit_surrogate_6_GE(struct solver_context *ctx, size_t max_n_phi,
+                                size_t n_P);
+int prealloc_fit_surrogate_6_LU(struct solver_context *ctx, size_t max_n_phi,
+                                size_t n_P);
+int prealloc_fit_surrogate_6_BLOCK_TRI(struct solver_context *ctx,
+                                       size_t max_n_phi, size_t n_P);
+int prealloc_fit_surrogate_6_LU_incremental(struct solver_context *ctx,
+                                            size_t max_n_phi, size_t n_P);
+int prealloc_fit_surrogate_6_LDLT(struct solver_context *ctx, size_t max_n_phi,
+                                  size_t n_P);
+int prealloc_fit_surrogate_6_NULLSPACE(struct solver_context *ctx,
+                                       size_t max_n_phi, size_t n_P);
+int prealloc_fit_surrogate_6_KRYLOV(struct solver_context *ctx,
+                                    size_t max_n_phi, size_t n_P);
 
 int fit_surrogate(struct pso_data_constant_inertia *pso)
 {
@@ -28,32 +43,27 @@ int fit_surrogate(struct pso_data_constant_inertia *pso)
   return ret;
 }
 
-int prealloc_fit_surrogate(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate(struct solver_context *ctx, size_t max_n_phi,
+                           size_t n_P)
 {
-  return FIT_SURROGATE_PREALLOC_VERSION(max_n_phi, n_P);
+  int ret = FIT_SURROGATE_PREALLOC_VERSION(ctx, max_n_phi, n_P);
+  ctx->max_n_phi = max_n_phi;
+  return ret;
 }
 
 #define DEBUG_SURROGATE 0
 
 // TODO: include past_refinement_points in phi !!!
 
-// is either [A | b] for GE and BLOCK_TRI or [A] for LU
-static double *fit_surrogate_Ab;
-static double *fit_surrogate_P;
-// if using LU
-static double *fit_surrogate_b;
-
-size_t fit_surrogate_max_N_phi;
-double *fit_surrogate_phi_cache;
-
-int prealloc_fit_surrogate_0(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_0(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * max_n_A + max_n_A;
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -71,7 +81,7 @@ int fit_surrogate_0(struct pso_data_constant_inertia *pso)
   // the size of the matrix in the linear system is n+d+1
   size_t n_A = n_phi + n_P;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
   /********
    * Prepare left hand side A
@@ -159,14 +169,15 @@ int fit_surrogate_0(struct pso_data_constant_inertia *pso)
   return 0;
 }
 
-int prealloc_fit_surrogate_1(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_1(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * max_n_A + max_n_A;
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -195,7 +206,7 @@ int fit_surrogate_1(struct pso_data_constant_inertia *pso)
   // the size of the matrix in the linear system is n+d+1
   size_t n_A = n_phi + n_P;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
   /********
    * Prepare left hand side A
@@ -283,17 +294,20 @@ int fit_surrogate_1(struct pso_data_constant_inertia *pso)
  * Cache distances computation: cache matrix phi
  */
 
-int prealloc_fit_surrogate_2(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_2(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * max_n_A + max_n_A;
 
-  fit_surrogate_max_N_phi = max_n_phi;
-  fit_surrogate_phi_cache = malloc(max_n_phi * max_n_phi * sizeof(double));
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache =
+      realloc(ctx->phi_cache, max_n_phi * max_n_phi * sizeof(double));
+  ctx->phi_cache_ld = max_n_phi;
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -318,10 +332,10 @@ int fit_surrogate_2(struct pso_data_constant_inertia *pso)
   // the size of the matrix in the linear system is n+d+1
   size_t n_A = n_phi + n_P;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -446,17 +460,20 @@ int fit_surrogate_2(struct pso_data_constant_inertia *pso)
  * Cache distances computation: same as before, but use memcpy
  */
 
-int prealloc_fit_surrogate_3(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_3(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * max_n_A + max_n_A;
 
-  fit_surrogate_max_N_phi = max_n_phi;
-  fit_surrogate_phi_cache = malloc(max_n_phi * max_n_phi * sizeof(double));
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache =
+      realloc(ctx->phi_cache, max_n_phi * max_n_phi * sizeof(double));
+  ctx->phi_cache_ld = max_n_phi;
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -481,10 +498,10 @@ int fit_surrogate_3(struct pso_data_constant_inertia *pso)
   // the size of the matrix in the linear system is n+d+1
   size_t n_A = n_phi + n_P;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -605,17 +622,20 @@ int fit_surrogate_3(struct pso_data_constant_inertia *pso)
  * Cache distances + early exit if no new elements
  */
 
-int prealloc_fit_surrogate_4(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_4(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * max_n_A + max_n_A;
 
-  fit_surrogate_max_N_phi = max_n_phi;
-  fit_surrogate_phi_cache = malloc(max_n_phi * max_n_phi * sizeof(double));
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache =
+      realloc(ctx->phi_cache, max_n_phi * max_n_phi * sizeof(double));
+  ctx->phi_cache_ld = max_n_phi;
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -640,10 +660,10 @@ int fit_surrogate_4(struct pso_data_constant_inertia *pso)
   // the size of the matrix in the linear system is n+d+1
   size_t n_A = n_phi + n_P;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -776,19 +796,20 @@ int fit_surrogate_4(struct pso_data_constant_inertia *pso)
  *
  * phi(i,j) with i<j stored at (j * (j-1) + i)
  */
-int prealloc_fit_surrogate_5(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_5(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * (max_n_A + 1);
   size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
 
-  fit_surrogate_max_N_phi = max_n_phi;
+  ctx->max_n_phi = max_n_phi;
 
-  fit_surrogate_phi_cache = malloc(phi_cache_size * sizeof(double));
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -814,10 +835,10 @@ int fit_surrogate_5(struct pso_data_constant_inertia *pso)
   size_t n_A = n_phi + n_P;
   size_t n_Ab = n_A + 1;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -935,14 +956,23 @@ int fit_surrogate_5(struct pso_data_constant_inertia *pso)
   return 0;
 }
 
-int prealloc_fit_surrogate_6(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_6(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P)
 {
 #if LINEAR_SYSTEM_SOLVER_USED == GE_SOLVER
-  return prealloc_fit_surrogate_6_GE(max_n_phi, n_P);
+  return prealloc_fit_surrogate_6_GE(ctx, max_n_phi, n_P);
 #elif LINEAR_SYSTEM_SOLVER_USED == LU_SOLVER
-  return prealloc_fit_surrogate_6_LU(max_n_phi, n_P);
+  return prealloc_fit_surrogate_6_LU(ctx, max_n_phi, n_P);
 #elif LINEAR_SYSTEM_SOLVER_USED == BLOCK_TRI_SOLVER
-  return prealloc_fit_surrogate_6_BLOCK_TRI(max_n_phi, n_P);
+  return prealloc_fit_surrogate_6_BLOCK_TRI(ctx, max_n_phi, n_P);
+#elif LINEAR_SYSTEM_SOLVER_USED == LU_INCREMENTAL_SOLVER
+  return prealloc_fit_surrogate_6_LU_incremental(ctx, max_n_phi, n_P);
+#elif LINEAR_SYSTEM_SOLVER_USED == LDLT_SOLVER
+  return prealloc_fit_surrogate_6_LDLT(ctx, max_n_phi, n_P);
+#elif LINEAR_SYSTEM_SOLVER_USED == NULLSPACE_SOLVER
+  return prealloc_fit_surrogate_6_NULLSPACE(ctx, max_n_phi, n_P);
+#elif LINEAR_SYSTEM_SOLVER_USED == KRYLOV_SOLVER
+  return prealloc_fit_surrogate_6_KRYLOV(ctx, max_n_phi, n_P);
 #endif
 }
 
@@ -954,6 +984,14 @@ int fit_surrogate_6(struct pso_data_constant_inertia *pso)
   return fit_surrogate_6_LU_blocked(pso);
 #elif LINEAR_SYSTEM_SOLVER_USED == BLOCK_TRI_SOLVER
   return fit_surrogate_6_BLOCK_TRI(pso);
+#elif LINEAR_SYSTEM_SOLVER_USED == LU_INCREMENTAL_SOLVER
+  return fit_surrogate_6_LU_incremental(pso);
+#elif LINEAR_SYSTEM_SOLVER_USED == LDLT_SOLVER
+  return fit_surrogate_6_LDLT(pso);
+#elif LINEAR_SYSTEM_SOLVER_USED == NULLSPACE_SOLVER
+  return fit_surrogate_6_NULLSPACE(pso);
+#elif LINEAR_SYSTEM_SOLVER_USED == KRYLOV_SOLVER
+  return fit_surrogate_6_KRYLOV(pso);
 #endif
 }
 
@@ -961,19 +999,20 @@ int fit_surrogate_6(struct pso_data_constant_inertia *pso)
  * Cooperation between prealloc_fit_surrogate_6 and check_distinct
  */
 
-int prealloc_fit_surrogate_6_GE(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_6_GE(struct solver_context *ctx, size_t max_n_phi,
+                                size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * (max_n_A + 1);
   size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
 
-  fit_surrogate_max_N_phi = max_n_phi;
+  ctx->max_n_phi = max_n_phi;
 
-  fit_surrogate_phi_cache = malloc(phi_cache_size * sizeof(double));
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -998,10 +1037,10 @@ int fit_surrogate_6_GE(struct pso_data_constant_inertia *pso)
   size_t n_A = n_phi + n_P;
   size_t n_Ab = n_A + 1;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -1102,7 +1141,8 @@ int fit_surrogate_6_GE(struct pso_data_constant_inertia *pso)
  * Cooperation between prealloc_fit_surrogate_6_LU and check_distinct
  */
 
-int prealloc_fit_surrogate_6_LU(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_6_LU(struct solver_context *ctx, size_t max_n_phi,
+                                size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and b is stored separately
@@ -1110,15 +1150,15 @@ int prealloc_fit_surrogate_6_LU(size_t max_n_phi, size_t n_P)
   size_t b_size = max_n_A;
   size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
 
-  fit_surrogate_max_N_phi = max_n_phi;
+  ctx->max_n_phi = max_n_phi;
 
-  fit_surrogate_phi_cache = malloc(phi_cache_size * sizeof(double));
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
-  fit_surrogate_b = malloc(b_size * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->b = realloc(ctx->b, b_size * sizeof(double));
 
-  lu_initialize_memory(n_P + max_n_phi);
+  lu_initialize_memory(ctx, n_P + max_n_phi);
   return 0;
 }
 
@@ -1143,12 +1183,12 @@ int fit_surrogate_6_LU(struct pso_data_constant_inertia *pso)
   size_t n_A = n_phi + n_P;
   size_t n_Ab = n_A + 1;
 
-  double *A = fit_surrogate_Ab;
+  double *A = pso->ctx.Ab;
 
-  double *b = fit_surrogate_b;
+  double *b = pso->ctx.b;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -1234,12 +1274,15 @@ int fit_surrogate_6_LU(struct pso_data_constant_inertia *pso)
   print_vectord(b, n_A, "b");
 #endif
 
-  if (lu_solve(n_A, A, b) < 0)
+  if (lu_solve(&pso->ctx, n_A, A, b) < 0)
   {
     return -1;
   }
 
-  // b is overwitten with the result of Ax = b in lu_solve
+  // b is overwitten with the result of Ax = b in lu_solve, it replaces the
+  // lambda_p buffer allocated by pso_constant_inertia_init
+  if (pso->lambda_p != b)
+    free(pso->lambda_p);
   pso->lambda_p = b;
 
 #if DEBUG_SURROGATE
@@ -1253,19 +1296,20 @@ int fit_surrogate_6_LU(struct pso_data_constant_inertia *pso)
  * Cooperation between prealloc_fit_surrogate_6 and check_distinct
  */
 
-int prealloc_fit_surrogate_6_BLOCK_TRI(size_t max_n_phi, size_t n_P)
+int prealloc_fit_surrogate_6_BLOCK_TRI(struct solver_context *ctx,
+                                       size_t max_n_phi, size_t n_P)
 {
   size_t max_n_A = max_n_phi + n_P;
   // Ab size: n x n for A and n x 1 for b
   size_t Ab_size = max_n_A * (max_n_A + 1);
   size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
 
-  fit_surrogate_max_N_phi = max_n_phi;
+  ctx->max_n_phi = max_n_phi;
 
-  fit_surrogate_phi_cache = malloc(phi_cache_size * sizeof(double));
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
 
-  fit_surrogate_Ab = malloc(Ab_size * sizeof(double));
-  fit_surrogate_P = malloc(max_n_phi * n_P * sizeof(double));
+  ctx->Ab = realloc(ctx->Ab, Ab_size * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
   return 0;
 }
 
@@ -1301,10 +1345,10 @@ int fit_surrogate_6_BLOCK_TRI(struct pso_data_constant_inertia *pso)
   size_t n_A = n_phi + n_P;
   size_t n_Ab = n_A + 1;
 
-  double *Ab = fit_surrogate_Ab;
+  double *Ab = pso->ctx.Ab;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
 
   /********
    * Prepare Phi
@@ -1429,12 +1473,12 @@ int fit_surrogate_6_LU_blocked(struct pso_data_constant_inertia *pso)
   size_t n_A = n_phi + n_P;
   size_t n_Ab = n_A + 1;
 
-  double *A = fit_surrogate_Ab;
+  double *A = pso->ctx.Ab;
 
-  double *b = fit_surrogate_b;
+  double *b = pso->ctx.b;
 
-  size_t max_N_phi = fit_surrogate_max_N_phi;
-  double *phi_cache = fit_surrogate_phi_cache;
+  size_t max_N_phi = pso->ctx.max_n_phi;
+  double *phi_cache = pso->ctx.phi_cache;
   /********
    * Prepare left hand side A
    ********/
@@ -1671,7 +1715,7 @@ int fit_surrogate_6_LU_blocked(struct pso_data_constant_inertia *pso)
 #endif
 
   PAPI_START("system_solver");
-  int ret = lu_solve(n_A, A, b);
+  int ret = lu_solve(&pso->ctx, n_A, A, b);
   PAPI_STOP("system_solver");
 
   if (ret < 0)
@@ -1679,7 +1723,10 @@ int fit_surrogate_6_LU_blocked(struct pso_data_constant_inertia *pso)
     return -1;
   }
 
-  // b is overwitten with the result of Ax = b in lu_solve
+  // b is overwitten with the result of Ax = b in lu_solve, it replaces the
+  // lambda_p buffer allocated by pso_constant_inertia_init
+  if (pso->lambda_p != b)
+    free(pso->lambda_p);
   pso->lambda_p = b;
 
 #if DEBUG_SURROGATE
@@ -1687,4 +1734,489 @@ int fit_surrogate_6_LU_blocked(struct pso_data_constant_inertia *pso)
 #endif
 
   return 0;
-}
\ No newline at end of file
+}
+/*
+ * Incremental LU / LDL^T
+ *
+ * The system is ordered [0 tP; P Phi] so that new points only append rows
+ * and columns. The factors of the previous batch are kept in
+ * the context's Ab (transposed layout, leading dimension max_n_A) and only
+ * the border of the new batch is eliminated against them, which makes a
+ * refit O(n^2 * k) instead of O(n^3) for k new points.
+ */
+
+typedef int (*factor_fun_t)(struct solver_context *ctx, int N, double *A,
+                            int LDA, int *ipiv);
+typedef int (*factor_border_fun_t)(struct solver_context *ctx, int N, int K,
+                                   double *A, int LDA, int *ipiv);
+typedef int (*solve_factored_fun_t)(struct solver_context *ctx, int N,
+                                    double *A, int LDA, int *ipiv,
+                                    double *b);
+
+int prealloc_fit_surrogate_6_LU_incremental(struct solver_context *ctx,
+                                            size_t max_n_phi, size_t n_P)
+{
+  size_t max_n_A = max_n_phi + n_P;
+
+  prealloc_fit_surrogate_6_LU(ctx, max_n_phi, n_P);
+
+  ctx->ipiv = realloc(ctx->ipiv, max_n_A * sizeof(int));
+  ctx->factored_ld = max_n_A;
+  ctx->factored_n_phi = 0;
+  return 0;
+}
+
+int prealloc_fit_surrogate_6_LDLT(struct solver_context *ctx, size_t max_n_phi,
+                                  size_t n_P)
+{
+  size_t max_n_A = max_n_phi + n_P;
+  // only the lower triangle of A is used, but A is not packed: it keeps the
+  // full max_n_A x max_n_A allocation of the LU solvers so that the leading
+  // dimension stays fixed and the factors can grow in place. The saving is
+  // in flops, not in memory.
+  size_t A_size = max_n_A * max_n_A;
+  size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
+
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
+
+  ctx->Ab = realloc(ctx->Ab, A_size * sizeof(double));
+  ctx->b = realloc(ctx->b, max_n_A * sizeof(double));
+
+  ctx->ipiv = realloc(ctx->ipiv, max_n_A * sizeof(int));
+  ctx->factored_ld = max_n_A;
+  ctx->factored_n_phi = 0;
+
+  ldlt_initialize_memory(ctx, max_n_A);
+  return 0;
+}
+
+// Write rows (and unless lower_only, columns) n_P + k1 : n_P + k2 of
+// [0 tP; P Phi] into A.
+static void fit_surrogate_LU_border(struct pso_data_constant_inertia *pso,
+                                    double *A, size_t LDA, size_t k1,
+                                    size_t k2, int lower_only)
+{
+  size_t dimensions = pso->dimensions;
+  size_t n_P = dimensions + 1;
+  double *phi_cache = pso->ctx.phi_cache;
+
+  for (size_t q = k1; q < k2; q++)
+  {
+    double *u = pso->x_distinct + q * dimensions;
+    double *d3_to_u_q_cached = phi_cache + q * (q - 1) / 2;
+    size_t c = n_P + q;
+
+    // P(q,0) = 1
+    TIX(A, LDA, c, 0) = 1;
+
+    // P(q,1+j) = u[j]
+    for (size_t j = 0; j < dimensions; j++)
+      TIX(A, LDA, c, 1 + j) = u[j];
+
+    // Phi(p,q) for p < q, all of those are already computed in
+    // check_if_distinct!
+    for (size_t p = 0; p < q; p++)
+      TIX(A, LDA, c, n_P + p) = d3_to_u_q_cached[p];
+
+    TIX(A, LDA, c, c) = 0.;
+
+    if (lower_only)
+      continue;
+
+    // mirror row c into column c
+    for (size_t r = 0; r < c; r++)
+      TIX(A, LDA, r, c) = TIX(A, LDA, c, r);
+  }
+}
+
+static int fit_surrogate_6_factored(struct pso_data_constant_inertia *pso,
+                                    factor_fun_t factor,
+                                    factor_border_fun_t factor_border,
+                                    solve_factored_fun_t solve_factored,
+                                    int lower_only)
+{
+  size_t n_phi = pso->x_distinct_s;
+  double *fxd = pso->x_distinct_eval;
+
+  // the size of P is n x d+1
+  size_t n_P = pso->dimensions + 1;
+
+  // the size of the matrix in the linear system is n+d+1
+  size_t n_A = n_phi + n_P;
+
+  double *A = pso->ctx.Ab;
+  double *b = pso->ctx.b;
+  int *ipiv = pso->ctx.ipiv;
+  size_t LDA = pso->ctx.factored_ld;
+
+  size_t prev_n_phi = pso->x_distinct_idx_of_last_batch;
+  if (prev_n_phi == n_phi)
+  {
+    // There are no new points ! The surrogate is already fit !
+#if DEBUG_SURROGATE
+    printf("Skip fit_surrogate: no new evaluation position!\n");
+#endif
+    return 0;
+  }
+  else
+  {
+    pso->x_distinct_idx_of_last_batch = n_phi;
+  }
+
+  int ret = -1;
+
+  PAPI_START("system_solver");
+
+  // The stored factors can only be extended if they describe exactly the
+  // points of the previous batch.
+  if (0 < pso->ctx.factored_n_phi && pso->ctx.factored_n_phi == prev_n_phi)
+  {
+#if DEBUG_SURROGATE
+    printf("Extend factors by %zu new points\n", n_phi - prev_n_phi);
+#endif
+    fit_surrogate_LU_border(pso, A, LDA, prev_n_phi, n_phi, lower_only);
+    ret = factor_border(&pso->ctx, n_P + prev_n_phi, n_phi - prev_n_phi, A, LDA,
+                        ipiv);
+  }
+
+  // Otherwise (or if the border was singular or unstable) factor from
+  // scratch
+  if (ret != 0)
+  {
+    // upper left block is zeros
+    for (size_t i = 0; i < n_P; i++)
+      for (size_t j = 0; j < n_P; j++)
+        TIX(A, LDA, i, j) = 0;
+
+    fit_surrogate_LU_border(pso, A, LDA, 0, n_phi, lower_only);
+    ret = factor(&pso->ctx, n_A, A, LDA, ipiv);
+  }
+
+  if (ret < 0)
+  {
+    pso->ctx.factored_n_phi = 0;
+    PAPI_STOP("system_solver");
+    return -1;
+  }
+  pso->ctx.factored_n_phi = n_phi;
+
+  /********
+   * Prepare right hand side b
+   ********/
+  for (size_t k = 0; k < n_P; k++)
+    b[k] = 0;
+  memcpy(b + n_P, fxd, n_phi * sizeof(double));
+
+  solve_factored(&pso->ctx, n_A, A, LDA, ipiv, b);
+
+  PAPI_STOP("system_solver");
+
+  // b is (p || lambda), lambda_p is (lambda || p)
+  memcpy(pso->lambda_p, b + n_P, n_phi * sizeof(double));
+  memcpy(pso->lambda_p + n_phi, b, n_P * sizeof(double));
+
+#if DEBUG_SURROGATE
+  print_vectord(pso->lambda_p, n_A, "x");
+#endif
+
+  return 0;
+}
+
+int fit_surrogate_6_LU_incremental(struct pso_data_constant_inertia *pso)
+{
+  return fit_surrogate_6_factored(pso, lu_factor, lu_factor_border,
+                                  lu_solve_factored, 0);
+}
+
+int fit_surrogate_6_LDLT(struct pso_data_constant_inertia *pso)
+{
+  return fit_surrogate_6_factored(pso, ldlt_factor, ldlt_factor_border,
+                                  ldlt_solve_factored, 1);
+}
+
+/*
+ * Null-space method
+ *
+ * The cubic kernel is conditionally positive definite of order 2, so with
+ * P = [Q1 Q2] R the projected Q2^T Phi Q2 is positive definite. The
+ * saddle point system is reduced to it and solved by Cholesky, there is no
+ * pivot search nor row interchange.
+ */
+
+int prealloc_fit_surrogate_6_NULLSPACE(struct solver_context *ctx,
+                                       size_t max_n_phi, size_t n_P)
+{
+  size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
+
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
+
+  ctx->Ab = realloc(ctx->Ab, max_n_phi * max_n_phi * sizeof(double));
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
+
+  nullspace_initialize_memory(ctx, max_n_phi, n_P);
+  return 0;
+}
+
+int fit_surrogate_6_NULLSPACE(struct pso_data_constant_inertia *pso)
+{
+  size_t dimensions = pso->dimensions;
+
+  size_t n_phi = pso->x_distinct_s;
+  double *x_distincts = pso->x_distinct;
+  double *fxd = pso->x_distinct_eval;
+
+  // the size of P is n x d+1
+  size_t n_P = dimensions + 1;
+
+  double *A = pso->ctx.Ab;
+  double *P = pso->ctx.P;
+  double *phi_cache = pso->ctx.phi_cache;
+
+  size_t prev_n_phi = pso->x_distinct_idx_of_last_batch;
+  if (prev_n_phi == n_phi)
+  {
+    // There are no new points ! The surrogate is already fit !
+#if DEBUG_SURROGATE
+    printf("Skip fit_surrogate: no new evaluation position!\n");
+#endif
+    return 0;
+  }
+  else
+  {
+    pso->x_distinct_idx_of_last_batch = n_phi;
+  }
+
+  // Phi (both triangles, leading dimension n_phi), all of those are
+  // already computed in check_if_distinct!
+  for (size_t j = 0; j < n_phi; j++)
+  {
+    double *d3_to_u_j_cached = phi_cache + j * (j - 1) / 2;
+
+    for (size_t i = 0; i < j; i++)
+    {
+      double phi_i_j = d3_to_u_j_cached[i];
+      TIX(A, n_phi, i, j) = phi_i_j;
+      TIX(A, n_phi, j, i) = phi_i_j;
+    }
+    TIX(A, n_phi, j, j) = 0.;
+  }
+
+  // P(k,0) = 1, P(k,1+j) = u[j]
+  for (size_t k = 0; k < n_phi; k++)
+    TIX(P, n_phi, k, 0) = 1;
+  for (size_t j = 0; j < dimensions; j++)
+    for (size_t k = 0; k < n_phi; k++)
+      TIX(P, n_phi, k, 1 + j) = x_distincts[k * dimensions + j];
+
+  PAPI_START("system_solver");
+  int ret = nullspace_solve(&pso->ctx, n_phi, n_P, A, n_phi, P, n_phi, fxd,
+                            pso->lambda_p);
+  PAPI_STOP("system_solver");
+
+  if (ret < 0)
+  {
+    return -1;
+  }
+
+#if DEBUG_SURROGATE
+  print_vectord(pso->lambda_p, n_phi + n_P, "x");
+#endif
+
+  return 0;
+}
+
+/*
+ * Projected preconditioned CG
+ *
+ * Neither Phi nor the saddle point matrix are assembled, the products
+ * stream from the phi cache. The points are only ever appended, so the
+ * previous (lambda || p) with zeros for the new points is a close initial
+ * guess.
+ */
+
+int prealloc_fit_surrogate_6_KRYLOV(struct solver_context *ctx,
+                                    size_t max_n_phi, size_t n_P)
+{
+  size_t phi_cache_size = max_n_phi * (max_n_phi - 1) / 2;
+
+  ctx->max_n_phi = max_n_phi;
+  ctx->phi_cache = realloc(ctx->phi_cache, phi_cache_size * sizeof(double));
+
+  ctx->P = malloc(max_n_phi * n_P * sizeof(double));
+
+  krylov_initialize_memory(ctx, max_n_phi, n_P);
+  return 0;
+}
+
+// Direct LDL^T fit of the current points for the batches where CG does not
+// converge. Its (max_n_phi + n_P)^2 matrix is only allocated once that
+// happens, and released again when the buffers grow since the factors are
+// never extended.
+static int fit_surrogate_KRYLOV_fallback(struct pso_data_constant_inertia *pso,
+                                         size_t prev_n_phi)
+{
+  struct solver_context *ctx = &pso->ctx;
+  size_t n_P = pso->dimensions + 1;
+
+  if (!ctx->Ab || ctx->factored_ld < ctx->max_n_phi + n_P)
+  {
+    ldlt_free_memory(ctx);
+    prealloc_fit_surrogate_6_LDLT(ctx, ctx->max_n_phi, n_P);
+  }
+
+  pso->x_distinct_idx_of_last_batch = prev_n_phi;
+  ctx->factored_n_phi = 0;
+  int ret = fit_surrogate_6_LDLT(pso);
+  ctx->factored_n_phi = 0;
+  return ret;
+}
+
+int fit_surrogate_6_KRYLOV(struct pso_data_constant_inertia *pso)
+{
+  size_t dimensions = pso->dimensions;
+
+  size_t n_phi = pso->x_distinct_s;
+  double *x_distincts = pso->x_distinct;
+  double *fxd = pso->x_distinct_eval;
+  double *lambda_p = pso->lambda_p;
+
+  // the size of P is n x d+1
+  size_t n_P = dimensions + 1;
+
+  double *P = pso->ctx.P;
+
+  size_t prev_n_phi = pso->x_distinct_idx_of_last_batch;
+  if (prev_n_phi == n_phi)
+  {
+    // There are no new points ! The surrogate is already fit !
+#if DEBUG_SURROGATE
+    printf("Skip fit_surrogate: no new evaluation position!\n");
+#endif
+    return 0;
+  }
+  else
+  {
+    pso->x_distinct_idx_of_last_batch = n_phi;
+  }
+
+  // Warm start: (lambda_old || 0 || p_old)
+  if (prev_n_phi == 0)
+  {
+    memset(lambda_p, 0, (n_phi + n_P) * sizeof(double));
+  }
+  else
+  {
+    memmove(lambda_p + n_phi, lambda_p + prev_n_phi, n_P * sizeof(double));
+    memset(lambda_p + prev_n_phi, 0, (n_phi - prev_n_phi) * sizeof(double));
+  }
+
+  // P(k,0) = 1, P(k,1+j) = u[j]
+  for (size_t k = 0; k < n_phi; k++)
+    TIX(P, n_phi, k, 0) = 1;
+  for (size_t j = 0; j < dimensions; j++)
+    for (size_t k = 0; k < n_phi; k++)
+      TIX(P, n_phi, k, 1 + j) = x_distincts[k * dimensions + j];
+
+  PAPI_START("system_solver");
+  int it = projected_cg_solve(&pso->ctx, n_phi, n_P, pso->ctx.phi_cache, P,
+                              n_phi, fxd, lambda_p);
+  PAPI_STOP("system_solver");
+
+  if (it < 0)
+  {
+    return -1;
+  }
+
+  // The last iterate is not a usable surrogate, fit this batch directly
+  if (it == KRYLOV_MAX_ITER)
+  {
+    fprintf(stderr,
+            "CG did not converge in %d iterations (residual %.3e), fit the "
+            "surrogate with LDL^T\n",
+            it, pso->ctx.krylov_residual);
+    return fit_surrogate_KRYLOV_fallback(pso, prev_n_phi);
+  }
+
+#if DEBUG_SURROGATE
+  printf("CG stopped after %d iterations\n", it);
+  print_vectord(lambda_p, n_phi + n_P, "x");
+#endif
+
+  return 0;
+}
+
+/*
+ * Capacity growth
+ *
+ * The buffers are sized for ctx->max_n_phi distinct points and grown to (at
+ * least) twice as many once more points come in, so the total cost of the
+ * copies stays linear in the final size. The prealloc functions realloc
+ * what outlives a fit (the phi cache, the incremental factors in Ab with
+ * their pivots and the solution in b, lambda_p may point to it), calling
+ * them again keeps the contents and only the square layouts need their
+ * rows moved to the new leading dimension. The rest is scratch and
+ * released first, so that it is not copied.
+ */
+int fit_surrogate_reserve(struct solver_context *ctx, size_t n_phi,
+                          size_t n_P)
+{
+  if (n_phi <= ctx->max_n_phi)
+    return 0;
+
+  size_t old_max_n_phi = ctx->max_n_phi;
+  size_t old_phi_cache_ld = ctx->phi_cache_ld;
+  size_t old_factored_ld = ctx->factored_ld;
+  size_t factored_n_phi = ctx->factored_n_phi;
+  int lu_mixed_fallback_n = ctx->lu_mixed_fallback_n;
+  size_t max_n_phi = MAX(n_phi, 2 * old_max_n_phi);
+
+  lu_free_memory(ctx);
+  ldlt_free_memory(ctx);
+  nullspace_free_memory(ctx);
+  krylov_free_memory(ctx);
+  free(ctx->P);
+  ctx->P = NULL;
+  if (!factored_n_phi)
+  {
+    free(ctx->Ab);
+    ctx->Ab = NULL;
+  }
+
+  int ret = prealloc_fit_surrogate(ctx, max_n_phi, n_P);
+  ctx->lu_mixed_fallback_n = lu_mixed_fallback_n;
+
+  // the packed phi cache just gets new rows, rows of the square one move
+  if (old_phi_cache_ld)
+  {
+    for (size_t q = old_max_n_phi; q-- > 1;)
+      memmove(ctx->phi_cache + q * ctx->phi_cache_ld,
+              ctx->phi_cache + q * old_phi_cache_ld,
+              old_max_n_phi * sizeof(double));
+  }
+
+  if (factored_n_phi)
+  {
+    size_t n_A = n_P + factored_n_phi;
+    for (size_t j = n_A; j-- > 1;)
+      memmove(&TIX(ctx->Ab, ctx->factored_ld, 0, j),
+              &TIX(ctx->Ab, old_factored_ld, 0, j), n_A * sizeof(double));
+    ctx->factored_n_phi = factored_n_phi;
+  }
+
+  return ret;
+}
+
+void free_fit_surrogate(struct solver_context *ctx)
+{
+  free(ctx->Ab);
+  free(ctx->P);
+  free(ctx->b);
+  free(ctx->phi_cache);
+  free(ctx->ipiv);
+  ctx->Ab = ctx->P = ctx->b = ctx->phi_cache = NULL;
+  ctx->ipiv = NULL;
+  ctx->max_n_phi = ctx->phi_cache_ld = 0;
+  ctx->factored_ld = ctx->factored_n_phi = 0;
+}
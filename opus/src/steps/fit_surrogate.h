@@ -10,7 +10,14 @@ typedef int (*fit_surrogate_fun_t)(struct pso_data_constant_inertia *);
 #endif
 
 int fit_surrogate(struct pso_data_constant_inertia *pso);
-int prealloc_fit_surrogate(size_t max_n_phi, size_t n_P);
+int prealloc_fit_surrogate(struct solver_context *ctx, size_t max_n_phi,
+                           size_t n_P);
+// Grow the buffers to at least n_phi distinct points, keeping the phi cache
+// and the incremental factors. Does nothing if they are already large enough.
+int fit_surrogate_reserve(struct solver_context *ctx, size_t n_phi,
+                          size_t n_P);
+// Release the buffers of whichever prealloc_fit_surrogate_* was used
+void free_fit_surrogate(struct solver_context *ctx);
 
 int fit_surrogate_0(struct pso_data_constant_inertia *pso);
 int fit_surrogate_1(struct pso_data_constant_inertia *pso);
@@ -21,10 +28,17 @@ int fit_surrogate_5(struct pso_data_constant_inertia *pso);
 int fit_surrogate_6(struct pso_data_constant_inertia *pso);
 int fit_surrogate_6_LU_blocked(struct pso_data_constant_inertia *pso);
 
-int prealloc_fit_surrogate_0(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_1(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_2(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_3(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_4(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_5(size_t max_n_phi, size_t n_P);
-int prealloc_fit_surrogate_6(size_t max_n_phi, size_t n_P);
+int prealloc_fit_surrogate_0(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_1(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_2(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_3(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_4(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_5(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
+int prealloc_fit_surrogate_6(struct solver_context *ctx, size_t max_n_phi,
+                             size_t n_P);
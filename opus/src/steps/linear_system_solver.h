@@ -1,13 +1,25 @@
 #pragma once
 
 #ifndef LINEAR_SYSTEM_SOLVER_USED
-#define LINEAR_SYSTEM_SOLVER_USED LU_SOLVER
+#define LINEAR_SYSTEM_SOLVER_USED LDLT_SOLVER
 #endif
 
 #define GE_SOLVER 1
 #define LU_SOLVER 2
 #define BLOCK_TRI_SOLVER 3
+// LU factors kept across batches and extended with the new points
+#define LU_INCREMENTAL_SOLVER 4
+// Same as LU_INCREMENTAL_SOLVER with a symmetric (Bunch-Kaufman) LDL^T
+#define LDLT_SOLVER 5
+// QR of P and Cholesky of the projected Phi
+#define NULLSPACE_SOLVER 6
+// Warm started projected CG streaming from the phi cache, Phi is never
+// assembled
+#define KRYLOV_SOLVER 7
 
 #include "../gaussian_elimination_solver.h"
+#include "../krylov_solve.h"
+#include "../ldlt_solve.h"
 #include "../lu_solve.h"
+#include "../nullspace_solve.h"
 #include "../triangular_system_solver.h"
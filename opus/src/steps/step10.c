@@ -18,10 +18,81 @@ void step10_base(struct pso_data_constant_inertia *pso)
   // Local refinement
   local_optimization(&surrogate_eval_void, pso->dimensions, pso->y_hat,
                      pso->local_refinement_box_size, pso->bound_low,
-                     pso->bound_high, pso, pso->x_local);
+                     pso->bound_high, pso, pso->x_local,
+                     pso->local_refinement_work);
+  pso->x_local_starts = 1;
+}
+
+double surrogate_eval_grad_void(double const *x, double *grad,
+                                void const *args)
+{
+  struct pso_data_constant_inertia const *pso =
+      (struct pso_data_constant_inertia const *)args;
+  return surrogate_eval_grad(pso, x, grad);
+}
+
+void step10_opt1(struct pso_data_constant_inertia *pso)
+{
+  local_optimization_lbfgsb(&surrogate_eval_grad_void, pso->dimensions,
+                            pso->y_hat, pso->local_refinement_box_size,
+                            pso->bound_low, pso->bound_high, pso,
+                            pso->x_local, pso->local_refinement_work);
+  pso->x_local_starts = 1;
+}
+
+// y_hat and the best personal bests other than y_hat, by increasing
+// evaluation
+static int step10_centers(struct pso_data_constant_inertia const *pso,
+                          int starts, double const **centers)
+{
+  double evals[LOCAL_REFINEMENT_STARTS];
+  int n = 1;
+  centers[0] = pso->y_hat;
+  evals[0] = pso->y_hat_eval;
+
+  for (int i = 0; i < pso->population_size; i++)
+  {
+    double const *y = PSO_Y(pso, i);
+    double y_eval = pso->y_eval[i];
+    if (y == pso->y_hat || (n == starts && y_eval >= evals[n - 1]))
+      continue;
+
+    // insertion in centers[1 : n]
+    int k = n < starts ? n++ : n - 1;
+    for (; k > 1 && evals[k - 1] > y_eval; k--)
+    {
+      centers[k] = centers[k - 1];
+      evals[k] = evals[k - 1];
+    }
+    centers[k] = y;
+    evals[k] = y_eval;
+  }
+  return n;
+}
+
+void step10_opt2(struct pso_data_constant_inertia *pso)
+{
+  size_t d = pso->dimensions;
+  double const *centers[LOCAL_REFINEMENT_STARTS];
+  int starts = step10_centers(
+      pso, MIN(LOCAL_REFINEMENT_STARTS, pso->population_size), centers);
+
+  // the surrogate is only read, each start has its own x_local and work
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int j = 0; j < starts; j++)
+  {
+    local_optimization_lbfgsb(
+        &surrogate_eval_grad_void, d, centers[j],
+        pso->local_refinement_box_size, pso->bound_low, pso->bound_high, pso,
+        pso->x_local + j * d,
+        pso->local_refinement_work + j * LOCAL_OPTIMIZATION_WORK_SIZE(d));
+  }
+  pso->x_local_starts = starts;
 }
 
 void step10_optimized(struct pso_data_constant_inertia *pso)
 {
-  step10_base(pso);
+  STEP10_VERSION(pso);
 }
@@ -2,5 +2,14 @@
 
 #include "../pso.h"
 
+#ifndef STEP10_VERSION
+#define STEP10_VERSION step10_opt1
+#endif
+
 void step10_base(struct pso_data_constant_inertia *pso);
+// projected L-BFGS on the surrogate, with its analytic gradient
+void step10_opt1(struct pso_data_constant_inertia *pso);
+// step10_opt1 from y_hat and the next best personal bests, up to
+// LOCAL_REFINEMENT_STARTS of them, concurrently
+void step10_opt2(struct pso_data_constant_inertia *pso);
 void step10_optimized(struct pso_data_constant_inertia *pso);
@@ -4,29 +4,75 @@
 #include <string.h>
 
 #include "../distincts.h"
+#include "../evaluate.h"
+#include "../helpers.h"
+#include "../local_refinement.h"
 
 void step11_base(struct pso_data_constant_inertia *pso)
 {
-  double *x_local = pso->x_local;
   // Determine if minimizer of surrogate is far from previous points
   // if it is add it to the bloom filter (if enabled) ...
-  if (check_if_distinct(pso, x_local, 1))
+  double x_local_eval[LOCAL_REFINEMENT_STARTS];
+  size_t n = step11_ask(pso);
+  if (n == 1)
+    x_local_eval[0] = pso_evaluate(pso, pso->x_local);
+  else if (n > 1)
+    pso_evaluate_batch(pso, n, pso->x_local, x_local_eval);
+  step11_tell(pso, x_local_eval);
+}
+
+size_t step11_ask(struct pso_data_constant_inertia *pso)
+{
+  size_t dim = pso->dimensions;
+
+  if (pso->x_local_starts == 1)
+    return pso->x_local_n = check_if_distinct(pso, pso->x_local, 1);
+
+  // several minimizers: keep the ones far from the ones kept before them and
+  // from x_distinct. The bloom filter records every kept point right away,
+  // so that it is the earlier points of the batch that shadow x here, before
+  // x is evaluated. Their phi rows are cached by step11_tell, once the
+  // previous ones are in x_distinct
+  size_t n = 0;
+  for (int j = 0; j < pso->x_local_starts; j++)
   {
-    double x_local_eval = pso->f(x_local);
+    double *x = pso->x_local + j * dim;
+    int distinct = 1;
+    for (size_t k = 0; k < n && distinct; k++)
+      distinct = !(dist2(dim, x, pso->x_local + k * dim) < pso->min_dist2);
+    distinct =
+        distinct && check_if_distinct(pso, x, DISTINCTIVENESS_CHECK_TYPE == 2);
 
-    // ... and add new refinement point and its evaluation to list of distinct
-    // evaluation positions
+    if (distinct)
+    {
+      memmove(pso->x_local + n * dim, x, dim * sizeof(double));
+      n++;
+    }
+  }
+  return pso->x_local_n = n;
+}
 
+void step11_tell(struct pso_data_constant_inertia *pso,
+                 double const *x_local_eval)
+{
+  // ... and add new refinement points and their evaluations to list of
+  // distinct evaluation positions
+  for (size_t k = 0; k < pso->x_local_n; k++)
+  {
+    double const *x = pso->x_local + k * pso->dimensions;
     double *x_local_in_xdistinct =
-        add_to_distincts_unconditionnaly(pso, x_local, x_local_eval);
+        pso->x_local_starts > 1
+            ? add_to_distincts_checked(pso, x, x_local_eval[k])
+            : add_to_distincts_unconditionnaly(pso, x, x_local_eval[k]);
 
     // update overall best if applicable
-    if (x_local_eval < pso->y_hat_eval)
+    if (x_local_eval[k] < pso->y_hat_eval)
     {
       pso->y_hat = x_local_in_xdistinct;
-      pso->y_hat_eval = x_local_eval;
+      pso->y_hat_eval = x_local_eval[k];
     }
   }
+  pso->x_local_n = 0;
 }
 
 void step11_optimized(struct pso_data_constant_inertia *pso)
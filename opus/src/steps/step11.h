@@ -4,3 +4,9 @@
 
 void step11_base(struct pso_data_constant_inertia *pso);
 void step11_optimized(struct pso_data_constant_inertia *pso);
+
+// The two halves of step11_base: the number of points of x_local to
+// evaluate, moved to its front, and the update with their evaluations
+size_t step11_ask(struct pso_data_constant_inertia *pso);
+void step11_tell(struct pso_data_constant_inertia *pso,
+                 double const *x_local_eval);
@@ -1,6 +1,7 @@
 #include "step1_2.h"
 
 #include "../distincts.h"
+#include "../evaluate.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -73,4 +74,48 @@ void step1_2_opt0(struct pso_data_constant_inertia *pso, size_t sfd_size,
   }
 
   free(z_eval);
-}
\ No newline at end of file
+}
+
+/*
+ * opt1: evaluate the whole design in one batch, then add the points in
+ * design order
+ */
+void step1_2_opt1(struct pso_data_constant_inertia *pso, size_t sfd_size,
+                  double *space_filling_design)
+{
+  double *fz = malloc(sfd_size * sizeof(double));
+
+  pso_evaluate_batch(pso, sfd_size, space_filling_design, fz);
+  step1_2_tell(pso, sfd_size, space_filling_design, fz);
+
+  free(fz);
+}
+
+void step1_2_tell(struct pso_data_constant_inertia *pso, size_t sfd_size,
+                  double *space_filling_design, double const *fz)
+{
+  struct id_and_eval *z_eval = malloc(sfd_size * sizeof(struct id_and_eval));
+
+  for (size_t k = 0; k < sfd_size; k++)
+  {
+    double *z = space_filling_design + k * pso->dimensions;
+    add_to_distincts_if_distinct(pso, z, fz[k]);
+
+    z_eval[k].id = k;
+    z_eval[k].eval = fz[k];
+  }
+
+  qsort(z_eval, sfd_size, sizeof(struct id_and_eval), &id_and_eval_compar);
+
+  // take the popsize smallest in the initial positions
+  for (int i = 0; i < pso->population_size; i++)
+  {
+    struct id_and_eval zi = z_eval[i];
+    double *z = space_filling_design + zi.id * pso->dimensions;
+
+    memcpy(PSO_X(pso, i), z, pso->dimensions * sizeof(double));
+    PSO_FX(pso, i) = zi.eval;
+  }
+
+  free(z_eval);
+}
@@ -3,7 +3,7 @@
 #include "../pso.h"
 
 #ifndef STEP1_2_VERSION
-#define STEP1_2_VERSION step1_2_opt0
+#define STEP1_2_VERSION step1_2_opt1
 #endif
 
 void step1_2(struct pso_data_constant_inertia *pso, size_t sfd_size,
@@ -11,3 +11,9 @@ void step1_2(struct pso_data_constant_inertia *pso, size_t sfd_size,
 
 void step1_2_opt0(struct pso_data_constant_inertia *pso, size_t sfd_size,
                   double *space_filling_design);
+void step1_2_opt1(struct pso_data_constant_inertia *pso, size_t sfd_size,
+                  double *space_filling_design);
+
+// Second half of step1_2_opt1, given the evaluations fz of the design
+void step1_2_tell(struct pso_data_constant_inertia *pso, size_t sfd_size,
+                  double *space_filling_design, double const *fz);
@@ -2,6 +2,8 @@
 
 #include "step4.h"
 
+#include "../evaluate.h"
+
 void step4(struct pso_data_constant_inertia *pso) { STEP4_VERSION(pso); }
 
 // Step 4. Initialise y, y_eval, and x_eval for each particle
@@ -294,3 +296,31 @@ void step4_opt1_memcpy(struct pso_data_constant_inertia *pso)
   pso->y_hat = min0;
   pso->y_hat_eval = min0_eval;
 }
+
+/*
+ * opt2: evaluate the population in one batch, the positions taken from the
+ * space filling design by step 1-2 are found in the evaluation cache
+ */
+void step4_opt2(struct pso_data_constant_inertia *pso)
+{
+  pso_evaluate_batch(pso, pso->population_size, pso->x, pso->x_eval);
+  step4_tell(pso);
+}
+
+void step4_tell(struct pso_data_constant_inertia *pso)
+{
+  int pop_size = pso->population_size;
+  int dim = pso->dimensions;
+
+  memcpy(pso->y, pso->x, pop_size * dim * sizeof(double));
+  memcpy(pso->y_eval, pso->x_eval, pop_size * sizeof(double));
+
+  // find ŷ, the first of equal minima as in step4_base
+  int i_min = 0;
+  for (int i = 1; i < pop_size; i++)
+    if (pso->y_eval[i] < pso->y_eval[i_min])
+      i_min = i;
+
+  pso->y_hat = PSO_Y(pso, i_min);
+  pso->y_hat_eval = pso->y_eval[i_min];
+}
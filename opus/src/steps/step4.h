@@ -3,11 +3,15 @@
 #include "../pso.h"
 
 #ifndef STEP4_VERSION
-#define STEP4_VERSION step4_opt1_memcpy
+#define STEP4_VERSION step4_opt2
 #endif
 
 void step4(struct pso_data_constant_inertia *pso);
 
 void step4_base(struct pso_data_constant_inertia *pso);
 void step4_opt1(struct pso_data_constant_inertia *pso);
-void step4_opt1_memcpy(struct pso_data_constant_inertia *pso);
\ No newline at end of file
+void step4_opt1_memcpy(struct pso_data_constant_inertia *pso);
+void step4_opt2(struct pso_data_constant_inertia *pso);
+
+// Second half of step4_opt2, x_eval holds the evaluations of x
+void step4_tell(struct pso_data_constant_inertia *pso);
@@ -13,17 +13,15 @@
 
 #include "../logging.h"
 
-void step5_base(struct pso_data_constant_inertia *pso)
+void step5_fit(struct pso_data_constant_inertia *pso, int batch)
 {
-  // Step 5.
-  // Fit surrogate
-  // f already evaluated on x[0..t][0..i-1]
-
   // Build set of distinct points: add latest x positions
-  for (size_t i = 0; i < pso->population_size; i++)
-  {
-    add_to_distincts_if_distinct(pso, PSO_X(pso, i), pso->x_eval[i]);
-  }
+  if (batch)
+    add_to_distincts_if_distinct_batch(pso, pso->x, pso->x_eval,
+                                       pso->population_size);
+  else
+    for (int i = 0; i < pso->population_size; i++)
+      add_to_distincts_if_distinct(pso, PSO_X(pso, i), pso->x_eval[i]);
 
   TIMING_INIT();
   if (fit_surrogate(pso) < 0)
@@ -34,4 +32,16 @@ void step5_base(struct pso_data_constant_inertia *pso)
   TIMING_STEP("fit_surrogate", STR(FIT_SURROGATE_VERSION), pso->time);
 }
 
-void step5_optimized(struct pso_data_constant_inertia *pso) { step5_base(pso); }
+void step5_base(struct pso_data_constant_inertia *pso)
+{
+  // Step 5.
+  // Fit surrogate
+  // f already evaluated on x[0..t][0..i-1]
+  step5_fit(pso, 0);
+}
+
+void step5_optimized(struct pso_data_constant_inertia *pso)
+{
+  // the population is checked in one batch
+  step5_fit(pso, 1);
+}
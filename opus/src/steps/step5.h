@@ -2,5 +2,10 @@
 
 #include "../pso.h"
 
+// Add the population to x_distinct and refit the surrogate, shared with step
+// 9. With batch, the population is checked by
+// add_to_distincts_if_distinct_batch instead of one point at a time.
+void step5_fit(struct pso_data_constant_inertia *pso, int batch);
+
 void step5_base(struct pso_data_constant_inertia *pso);
 void step5_optimized(struct pso_data_constant_inertia *pso);
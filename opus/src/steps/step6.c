@@ -7,6 +7,10 @@
 
 #include "surrogate_eval.h"
 
+#include "../philox.h"
+
+#include "../threads.h"
+
 static double clamp(double v, double lo, double hi)
 {
   if (v < lo)
@@ -104,28 +108,34 @@ void step6_base(struct pso_data_constant_inertia *pso)
   }
 }
 
+// The random numbers w1, w2 of trial l of particle i at the current time,
+// 2 * dimensions of them. They only depend on (time, i, l) and the key, not
+// on the order in which the trials are generated.
+static inline void step6_rands(struct pso_data_constant_inertia const *pso,
+                               int i, int l, double *w)
+{
+  philox_uniform(pso->rng_key, pso->time, i, l, 2 * pso->dimensions, w);
+}
+
 /*
- * use precomputed RAND variables
+ * use precomputed RAND variables (now drawn per trial from the counter based
+ * generator)
  */
 void step6_opt1(struct pso_data_constant_inertia *pso)
 {
   // Determine new particle positions
-  int time = pso->time;
   int pop_size = pso->population_size;
   int dim = pso->dimensions;
   int n_trials = pso->n_trials;
 
-  size_t rand_pool_size = 2 * pop_size * n_trials * dim;
-  double const *rand_pool =
-      pso->step6_rands_array_start + time * rand_pool_size;
-
   for (int i = 0; i < pop_size; i++)
   {
     double x_trial_best_seval = DBL_MAX;
     for (int l = 0; l < n_trials; l++)
     {
 
-      double const *row_ptr = rand_pool + (i * n_trials + l) * 2 * dim;
+      double const *row_ptr = pso->step6_rands;
+      step6_rands(pso, i, l, pso->step6_rands);
 
       for (int j = 0; j < dim; j++)
       {
@@ -179,22 +189,18 @@ void step6_opt1(struct pso_data_constant_inertia *pso)
 void step6_opt2(struct pso_data_constant_inertia *pso)
 {
   // Determine new particle positions
-  int time = pso->time;
   int pop_size = pso->population_size;
   int dim = pso->dimensions;
   int n_trials = pso->n_trials;
 
-  size_t rand_pool_size = 2 * pop_size * n_trials * dim;
-  double const *rand_pool =
-      pso->step6_rands_array_start + time * rand_pool_size;
-
   for (int i = 0; i < pop_size; i++)
   {
     double x_trial_best_seval = DBL_MAX;
     for (int l = 0; l < n_trials; l++)
     {
 
-      double const *row_ptr = rand_pool + (i * n_trials + l) * 2 * dim;
+      double const *row_ptr = pso->step6_rands;
+      step6_rands(pso, i, l, pso->step6_rands);
 
       int j = 0;
       for (; j < dim; j += 4)
@@ -303,22 +309,18 @@ void step6_opt2(struct pso_data_constant_inertia *pso)
 void step6_opt3(struct pso_data_constant_inertia *pso)
 {
   // Determine new particle positions
-  int time = pso->time;
   int pop_size = pso->population_size;
   int dim = pso->dimensions;
   int n_trials = pso->n_trials;
 
-  size_t rand_pool_size = 2 * pop_size * n_trials * dim;
-  double const *rand_pool =
-      pso->step6_rands_array_start + time * rand_pool_size;
-
   for (int i = 0; i < pop_size; i++)
   {
     double x_trial_best_seval = DBL_MAX;
     for (int l = 0; l < n_trials; l++)
     {
 
-      double const *row_ptr = rand_pool + (i * n_trials + l) * 2 * dim;
+      double const *row_ptr = pso->step6_rands;
+      step6_rands(pso, i, l, pso->step6_rands);
 
       int j = 0;
       for (; j < dim - 3; j += 4)
@@ -428,6 +430,153 @@ void step6_opt3(struct pso_data_constant_inertia *pso)
   }
 }
 
+// Velocity and position of one trial of particle i, row_ptr holds the
+// random numbers of this trial
+static inline void step6_trial(struct pso_data_constant_inertia const *pso,
+                               int i, double const *row_ptr, double *x_trial,
+                               double *v_trial)
+{
+  int dim = pso->dimensions;
+  double const *pso_v = PSO_V(pso, i);
+  double const *pso_x = PSO_X(pso, i);
+  double const *pso_y = PSO_Y(pso, i);
+
+  __m256d inertia = _mm256_set1_pd(pso->inertia);
+  __m256d cognition = _mm256_set1_pd(pso->cognition);
+  __m256d social = _mm256_set1_pd(pso->social);
+
+  int j = 0;
+  for (; j < dim - 3; j += 4)
+  {
+    int j2 = j * 2;
+    __m256d x = _mm256_loadu_pd(pso_x + j);
+
+    // inertia * v + cognition * w1 * (y - x) + social * w2 * (y_hat - x)
+    __m256d v = _mm256_mul_pd(inertia, _mm256_loadu_pd(pso_v + j));
+    v = _mm256_fmadd_pd(_mm256_mul_pd(cognition, _mm256_loadu_pd(row_ptr + j2)),
+                        _mm256_sub_pd(_mm256_loadu_pd(pso_y + j), x), v);
+    v = _mm256_fmadd_pd(
+        _mm256_mul_pd(social, _mm256_loadu_pd(row_ptr + j2 + 4)),
+        _mm256_sub_pd(_mm256_loadu_pd(pso->y_hat + j), x), v);
+
+    v = _mm256_max_pd(_mm256_loadu_pd(pso->vmin + j), v);
+    v = _mm256_min_pd(_mm256_loadu_pd(pso->vmax + j), v);
+
+    x = _mm256_add_pd(x, v);
+    x = _mm256_max_pd(_mm256_loadu_pd(pso->bound_low + j), x);
+    x = _mm256_min_pd(_mm256_loadu_pd(pso->bound_high + j), x);
+
+    _mm256_storeu_pd(v_trial + j, v);
+    _mm256_storeu_pd(x_trial + j, x);
+  }
+
+  for (; j < dim; j++)
+  {
+    double w1 = row_ptr[2 * j];
+    double w2 = row_ptr[2 * j + 1];
+
+    double v = pso->inertia * pso_v[j] +
+               pso->cognition * w1 * (pso_y[j] - pso_x[j]) +
+               pso->social * w2 * (pso->y_hat[j] - pso_x[j]);
+
+    v_trial[j] = clamp(v, pso->vmin[j], pso->vmax[j]);
+    x_trial[j] =
+        clamp(pso_x[j] + v_trial[j], pso->bound_low[j], pso->bound_high[j]);
+  }
+}
+
+/*
+ * generate all trials first and score them with one batched surrogate
+ * evaluation
+ */
+void step6_opt4(struct pso_data_constant_inertia *pso)
+{
+  // Determine new particle positions
+  int pop_size = pso->population_size;
+  int dim = pso->dimensions;
+  int n_trials = pso->n_trials;
+
+  for (int i = 0; i < pop_size; i++)
+    for (int l = 0; l < n_trials; l++)
+    {
+      step6_rands(pso, i, l, pso->step6_rands);
+      step6_trial(pso, i, pso->step6_rands,
+                  pso->x_trial_batch + (i * n_trials + l) * dim,
+                  pso->v_trial_batch + (i * n_trials + l) * dim);
+    }
+
+  surrogate_eval_batch(pso, pop_size * n_trials, pso->x_trial_batch,
+                       pso->x_trial_batch_seval);
+
+  for (int i = 0; i < pop_size; i++)
+  {
+    double const *seval = pso->x_trial_batch_seval + i * n_trials;
+    int l_best = 0;
+    for (int l = 1; l < n_trials; l++)
+      if (seval[l] < seval[l_best])
+        l_best = l;
+
+    // set next position and update velocity
+    memcpy(PSO_X(pso, i), pso->x_trial_batch + (i * n_trials + l_best) * dim,
+           dim * sizeof(double));
+    memcpy(PSO_V(pso, i), pso->v_trial_batch + (i * n_trials + l_best) * dim,
+           dim * sizeof(double));
+  }
+}
+
+/*
+ * particles in parallel, every thread keeps its best trial and the random
+ * numbers of the current one in its own slice of pso->trial_scratch
+ */
+void step6_opt5(struct pso_data_constant_inertia *pso)
+{
+  int pop_size = pso->population_size;
+  int dim = pso->dimensions;
+  int n_trials = pso->n_trials;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < pop_size; i++)
+  {
+    double *scratch =
+        pso->trial_scratch + omp_get_thread_num() * 6 * pso->trial_scratch_ld;
+    double *x_trial = scratch;
+    double *v_trial = scratch + pso->trial_scratch_ld;
+    double *x_trial_best = scratch + 2 * pso->trial_scratch_ld;
+    double *v_trial_best = scratch + 3 * pso->trial_scratch_ld;
+    double *w = scratch + 4 * pso->trial_scratch_ld;
+    double x_trial_best_seval = DBL_MAX;
+
+    for (int l = 0; l < n_trials; l++)
+    {
+      step6_rands(pso, i, l, w);
+      step6_trial(pso, i, w, x_trial, v_trial);
+
+      double x_trial_seval = surrogate_eval(pso, x_trial);
+
+      if (x_trial_seval < x_trial_best_seval)
+      {
+        x_trial_best_seval = x_trial_seval;
+
+        double *t;
+
+        t = x_trial;
+        x_trial = x_trial_best;
+        x_trial_best = t;
+
+        t = v_trial;
+        v_trial = v_trial_best;
+        v_trial_best = t;
+      }
+    }
+
+    // set next position and update velocity
+    memcpy(PSO_X(pso, i), x_trial_best, dim * sizeof(double));
+    memcpy(PSO_V(pso, i), v_trial_best, dim * sizeof(double));
+  }
+}
+
 void step6_optimized(struct pso_data_constant_inertia *pso)
 {
   //    step6_base(pso);
@@ -3,7 +3,7 @@
 #include "../pso.h"
 
 #ifndef STEP6_VERSION
-#define STEP6_VERSION step6_opt3
+#define STEP6_VERSION step6_opt4
 #endif
 
 void step6_base(struct pso_data_constant_inertia *pso);
@@ -1,5 +1,7 @@
 #include "step7.h"
 
+#include "../evaluate.h"
+
 void step7_base(struct pso_data_constant_inertia *pso)
 {
   // Evaluate swarm positions
@@ -9,4 +11,7 @@ void step7_base(struct pso_data_constant_inertia *pso)
   }
 }
 
-void step7_optimized(struct pso_data_constant_inertia *pso) { step7_base(pso); }
+void step7_optimized(struct pso_data_constant_inertia *pso)
+{
+  pso_evaluate_batch(pso, pso->population_size, pso->x, pso->x_eval);
+}
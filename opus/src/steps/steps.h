@@ -12,4 +12,5 @@
 #include "step8.h"
 #include "step9.h"
 
-#include "fit_surrogate.h"
\ No newline at end of file
+#include "fit_surrogate.h"
+#include "surrogate_eval.h"
\ No newline at end of file
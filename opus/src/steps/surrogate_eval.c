@@ -1,9 +1,13 @@
 #include "surrogate_eval.h"
 #include "math.h"
 #include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "linear_system_solver.h"
 
+#include "../blas/dgemm.h"
+
 #include "../helpers.h"
 
 #define QUOTE(x) #x
@@ -445,3 +449,206 @@ double surrogate_eval_5(struct pso_data_constant_inertia const *pso,
 
   return res;
 }
+
+/*
+ * s(x) = sum_k lambda_k |x - u_k|^3 + p_0 + sum_j p_(j+1) x_j, so
+ * grad s(x) = sum_k 3 lambda_k |x - u_k| (x - u_k) + (p_1 ... p_d).
+ * Both in one sweep over x_distinct, two centers at a time: the distances
+ * as in surrogate_eval_5, then the gradient update while the two centers
+ * are still in L1.
+ */
+double surrogate_eval_grad(struct pso_data_constant_inertia const *pso,
+                           double const *x_ptr, double *grad)
+{
+  size_t dim = pso->dimensions;
+
+  double *lambda_p = pso->lambda_p;
+#if LINEAR_SYSTEM_SOLVER_USED == BLOCK_TRI_SOLVER
+  double *lambda = lambda_p + pso->dimensions + 1;
+  double *p_coef = lambda_p;
+#else
+  double *lambda = lambda_p;
+  double *p_coef = lambda_p + pso->x_distinct_s;
+#endif
+
+  double res = p_coef[0];
+  for (size_t i = 0; i < dim; i++)
+  {
+    res += p_coef[i + 1] * x_ptr[i];
+    grad[i] = p_coef[i + 1];
+  }
+
+  size_t k = 0;
+  for (; k + 1 < pso->x_distinct_s; k += 2)
+  {
+    double const *u0_ptr = PSO_XD(pso, k);
+    double const *u1_ptr = PSO_XD(pso, k + 1);
+
+    __m256d s0 = _mm256_set1_pd(0);
+    __m256d s1 = _mm256_set1_pd(0);
+
+    size_t i = 0;
+    for (; i + 3 < dim; i += 4)
+    {
+      __m256d x = _mm256_loadu_pd(x_ptr + i);
+      __m256d v0 = _mm256_sub_pd(_mm256_loadu_pd(u0_ptr + i), x);
+      __m256d v1 = _mm256_sub_pd(_mm256_loadu_pd(u1_ptr + i), x);
+      s0 = _mm256_fmadd_pd(v0, v0, s0);
+      s1 = _mm256_fmadd_pd(v1, v1, s1);
+    }
+
+    __m256d t1 = _mm256_hadd_pd(s0, s1);
+    __m128d d2 = _mm_add_pd(_mm256_castpd256_pd128(t1),
+                            _mm256_extractf128_pd(t1, 1));
+    for (; i < dim; i++)
+    {
+      __m128d uv = _mm_loadh_pd(_mm_load1_pd(&u0_ptr[i]), &u1_ptr[i]);
+      __m128d diff = _mm_sub_pd(uv, _mm_load1_pd(&x_ptr[i]));
+      d2 = _mm_fmadd_pd(diff, diff, d2);
+    }
+
+    __m128d d = _mm_sqrt_pd(d2);
+    __m128d lambd = _mm_loadu_pd(&lambda[k]);
+    __m128d lambd_d3 = _mm_mul_pd(lambd, _mm_mul_pd(d, d2));
+    res += lambd_d3[0] + lambd_d3[1];
+
+    // grad += c0 (x - u0) + c1 (x - u1)
+    __m128d c = _mm_mul_pd(_mm_set1_pd(3.), _mm_mul_pd(lambd, d));
+    __m256d c0 = _mm256_set1_pd(c[0]);
+    __m256d c1 = _mm256_set1_pd(c[1]);
+    i = 0;
+    for (; i + 3 < dim; i += 4)
+    {
+      __m256d x = _mm256_loadu_pd(x_ptr + i);
+      __m256d g = _mm256_loadu_pd(grad + i);
+      g = _mm256_fmadd_pd(c0, _mm256_sub_pd(x, _mm256_loadu_pd(u0_ptr + i)),
+                          g);
+      g = _mm256_fmadd_pd(c1, _mm256_sub_pd(x, _mm256_loadu_pd(u1_ptr + i)),
+                          g);
+      _mm256_storeu_pd(grad + i, g);
+    }
+    for (; i < dim; i++)
+    {
+      grad[i] += c[0] * (x_ptr[i] - u0_ptr[i]) + c[1] * (x_ptr[i] - u1_ptr[i]);
+    }
+  }
+
+  for (; k < pso->x_distinct_s; k++)
+  {
+    double const *u = PSO_XD(pso, k);
+    double d2 = dist2(dim, x_ptr, u);
+    double d = sqrt(d2);
+    res += lambda[k] * d2 * d;
+
+    double c = 3. * lambda[k] * d;
+    for (size_t i = 0; i < dim; i++)
+      grad[i] += c * (x_ptr[i] - u[i]);
+  }
+
+  return res;
+}
+
+void surrogate_eval_initialize_memory(struct solver_context *ctx,
+                                      int dimensions)
+{
+  solver_context_dgemm_work(ctx);
+  ctx->seval_xt =
+      aligned_alloc(32, SEVAL_M_BLOCK * dimensions * sizeof(double));
+  ctx->seval_xn = aligned_alloc(32, SEVAL_M_BLOCK * sizeof(double));
+  ctx->seval_g =
+      aligned_alloc(32, SEVAL_M_BLOCK * SEVAL_N_BLOCK * sizeof(double));
+}
+
+void surrogate_eval_free_memory(struct solver_context *ctx)
+{
+  free(ctx->seval_xt);
+  free(ctx->seval_xn);
+  free(ctx->seval_g);
+  ctx->seval_xt = ctx->seval_xn = ctx->seval_g = NULL;
+}
+
+// out(0 : 4) += sum_j lambda_j * s_j^(3/2), s_j = max(G(:, j) + xn + un_j, 0)
+static inline __m256d seval_tile_4(int N, double const *G, int LDG,
+                                   __m256d xn, double const *un,
+                                   double const *lambda, __m256d acc)
+{
+  __m256d zero = _mm256_setzero_pd();
+  for (int j = 0; j < N; ++j, G += LDG)
+  {
+    __m256d s = _mm256_add_pd(_mm256_loadu_pd(G), xn);
+    s = _mm256_add_pd(s, _mm256_broadcast_sd(un + j));
+    s = _mm256_max_pd(s, zero); // cancellation for x close to u
+    s = _mm256_mul_pd(s, _mm256_sqrt_pd(s));
+    acc = _mm256_fmadd_pd(_mm256_broadcast_sd(lambda + j), s, acc);
+  }
+  return acc;
+}
+
+void surrogate_eval_batch(struct pso_data_constant_inertia const *pso,
+                          size_t m, double const *X, double *out)
+{
+  int dim = pso->dimensions;
+  int n = pso->x_distinct_s;
+  double *xt = pso->ctx.seval_xt, *xn = pso->ctx.seval_xn;
+  double *G = pso->ctx.seval_g;
+
+  double *lambda_p = pso->lambda_p;
+#if LINEAR_SYSTEM_SOLVER_USED == BLOCK_TRI_SOLVER
+  // lambda_p is the concatenation (p_0 ... p_(d+1) || lambda_0 ... lambda_i)
+  double *lambda = lambda_p + pso->dimensions + 1;
+  double *p_coef = lambda_p;
+#else
+  // lambda_p is the concatenation (lambda_0 ... lambda_i || p_0 ... p_(d+1))
+  double *lambda = lambda_p;
+  double *p_coef = lambda_p + pso->x_distinct_s;
+#endif
+
+  int i, j, k, d_i, d_j;
+  for (size_t i0 = 0; i0 < m; i0 += d_i)
+  {
+    d_i = MIN(m - i0, SEVAL_M_BLOCK);
+    double const *x = X + i0 * dim;
+
+    // xt := 2 X^T, so that dgemm leaves G = -2 X U^T
+    for (i = 0; i < d_i; ++i)
+    {
+      double s = p_coef[0];
+      for (k = 0; k < dim; ++k)
+      {
+        TIX(xt, d_i, i, k) = 2. * x[i * dim + k];
+        s += p_coef[k + 1] * x[i * dim + k];
+      }
+      xn[i] = norm2(dim, x + i * dim);
+      out[i0 + i] = s;
+    }
+
+    for (j = 0; j < n; j += d_j)
+    {
+      d_j = MIN(n - j, SEVAL_N_BLOCK);
+      memset(G, 0, d_i * d_j * sizeof(double));
+      // The centers stored row by row are U^T in the transposed layout
+      dgemm_5(d_i, d_j, dim, -1., xt, d_i, PSO_XD(pso, j), dim, 1., G, d_i,
+              pso->ctx.dgemm_work);
+
+      for (i = 0; i + 3 < d_i; i += 4)
+      {
+        __m256d acc = seval_tile_4(d_j, G + i, d_i, _mm256_loadu_pd(xn + i),
+                                   pso->x_distinct_norm2 + j, lambda + j,
+                                   _mm256_setzero_pd());
+        _mm256_storeu_pd(out + i0 + i,
+                         _mm256_add_pd(_mm256_loadu_pd(out + i0 + i), acc));
+      }
+      for (; i < d_i; ++i)
+      {
+        double acc = 0.;
+        for (k = 0; k < d_j; ++k)
+        {
+          double s = TIX(G, d_i, i, k) + xn[i] + pso->x_distinct_norm2[j + k];
+          s = 0. < s ? s : 0.;
+          acc += lambda[j + k] * s * sqrt(s);
+        }
+        out[i0 + i] += acc;
+      }
+    }
+  }
+}
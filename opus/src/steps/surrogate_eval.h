@@ -28,4 +28,39 @@ double surrogate_eval_4(struct pso_data_constant_inertia const *pso,
                         double const *x);
 
 double surrogate_eval_5(struct pso_data_constant_inertia const *pso,
-                        double const *x_ptr);
\ No newline at end of file
+                        double const *x_ptr);
+/** @brief Evaluate the surrogate and its gradient at x.
+ *
+ * @param pso: The pso state, lambda_p must be fitted on x_distinct.
+ * @param x: The point.
+ * @param grad: The gradient of the surrogate at x, dimensions doubles.
+ * @return The surrogate value at x.
+ */
+double surrogate_eval_grad(struct pso_data_constant_inertia const *pso,
+                           double const *x, double *grad);
+// Trials per block and centers per block of surrogate_eval_batch, a distance
+// tile is SEVAL_M_BLOCK x SEVAL_N_BLOCK doubles.
+#ifndef SEVAL_M_BLOCK
+#define SEVAL_M_BLOCK 64
+#endif
+#ifndef SEVAL_N_BLOCK
+#define SEVAL_N_BLOCK 128
+#endif
+
+/** @brief Evaluate the surrogate at m points at once.
+ *
+ * The squared distances of a block of points to a block of centers are
+ * computed as |u|^2 + |x|^2 - 2 u.x, the cross terms with one dgemm and the
+ * center norms from pso->x_distinct_norm2. The cube and lambda weighting
+ * are applied on the distance tile while it is still in cache.
+ *
+ * @param pso: The pso state, lambda_p must be fitted on x_distinct.
+ * @param m: Number of points.
+ * @param X: The points, m x dimensions row by row.
+ * @param out: The m surrogate values.
+ */
+void surrogate_eval_batch(struct pso_data_constant_inertia const *pso,
+                          size_t m, double const *X, double *out);
+void surrogate_eval_initialize_memory(struct solver_context *ctx,
+                                      int dimensions);
+void surrogate_eval_free_memory(struct solver_context *ctx);
@@ -0,0 +1,11 @@
+#pragma once
+
+// Thread parallel regions use OpenMP, enabled with `make WITH_OPENMP=1`.
+// Without it the pragmas are ignored and these stubs describe the single
+// thread that runs everything.
+#ifdef _OPENMP
+#include <omp.h>
+#else
+static inline int omp_get_max_threads() { return 1; }
+static inline int omp_get_thread_num() { return 0; }
+#endif
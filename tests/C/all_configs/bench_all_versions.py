@@ -64,6 +64,26 @@ CONFIGURATIONS[12] = {
         "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LU_blocked"],
         "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6_LU_blocked -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=2 -DLU_SOLVE_VERSION=lu_solve_6",
 }
+CONFIGURATIONS[13] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LU_incremental"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=4",
+}
+CONFIGURATIONS[14] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LDLT"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=5",
+}
+CONFIGURATIONS[15] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_NULLSPACE"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=6",
+}
+CONFIGURATIONS[16] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_KRYLOV"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=7",
+}
+CONFIGURATIONS[17] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LU_8"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=2 -DLU_SOLVE_VERSION=lu_solve_8",
+}
 
 
 
@@ -98,6 +118,43 @@ CONFIGURATIONS[55] = {
         "bench-flags": ["", ""],
         "CPPFLAGS": "-DSURROGATE_EVAL_VERSION=surrogate_eval_5",
 }
+CONFIGURATIONS[56] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DSTEP6_VERSION=step6_opt3",
+}
+CONFIGURATIONS[57] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DSTEP6_VERSION=step6_opt5",
+}
+CONFIGURATIONS[58] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": ("-DSTEP1_2_VERSION=step1_2_opt0 "
+                     "-DSTEP4_VERSION=step4_opt1_memcpy"),
+}
+CONFIGURATIONS[59] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DDISTINCTIVENESS_CHECK_TYPE=3",
+}
+CONFIGURATIONS[60] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DDISTINCTIVENESS_CHECK_TYPE=2",
+}
+CONFIGURATIONS[61] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DSTEP10_VERSION=step10_base",
+}
+CONFIGURATIONS[62] = {
+        "bench-flags": ["", ""],
+        "CPPFLAGS": "-DSTEP10_VERSION=step10_opt2",
+}
+CONFIGURATIONS[63] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LU_9"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=2 -DLU_SOLVE_VERSION=lu_solve_9",
+}
+CONFIGURATIONS[64] = {
+        "bench-flags": ["--bench-fit-surrogate", "fit_surrogate_6_LU_10"],
+        "CPPFLAGS": "-DFIT_SURROGATE_VERSION=fit_surrogate_6 -DFIT_SURROGATE_PREALLOC_VERSION=prealloc_fit_surrogate_6 -DCHECK_IF_DISTINCT_VERSION=check_if_distinct_1 -DLINEAR_SYSTEM_SOLVER_USED=2 -DLU_SOLVE_VERSION=lu_solve_10",
+}
 
 
 # baseline
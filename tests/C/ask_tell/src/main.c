@@ -0,0 +1,108 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ask_tell.h"
+#include "latin_hypercube.h"
+#include "pso.h"
+
+/*
+ * Drives the Griewank run of opus/src/main.c once through the callback
+ * steps of run_pso and once through pso_ask / pso_tell, with the points of
+ * every batch told in reverse order (its last point twice). Both have to
+ * find the same optimum with as many evaluations.
+ */
+
+#define POPSIZE 20
+#define DIMENSION 20
+#define SPACE_FILLING_DESIGN_SIZE 25
+#define SEED 42
+
+static double griewank_Nd(double const *const x)
+{
+  double r = 0;
+  double t = 1;
+
+  double d = 1. / 4000;
+
+  for (size_t i = 0; i < DIMENSION; i++)
+  {
+    double v = x[i];
+
+    r += v * v;
+    t *= cos(v / sqrt((double)i + 1));
+  }
+
+  return (1. + d * r - t);
+}
+
+static double bounds_low[DIMENSION], bounds_high[DIMENSION];
+static double vmin[DIMENSION], vmax[DIMENSION];
+
+static double space_filling_design[SPACE_FILLING_DESIGN_SIZE * DIMENSION];
+
+// The design and the swarm draw from rand() in this order in main.c
+static void init(struct pso_data_constant_inertia *pso, blackbox_fun f)
+{
+  double lh[SPACE_FILLING_DESIGN_SIZE * DIMENSION] = {0};
+  srand(SEED);
+  latin_hypercube(lh, SPACE_FILLING_DESIGN_SIZE, DIMENSION);
+  for (size_t i = 0; i < SPACE_FILLING_DESIGN_SIZE * DIMENSION; i++)
+  {
+    size_t k = i % DIMENSION;
+    space_filling_design[i] =
+        bounds_low[k] + (bounds_high[k] - bounds_low[k]) * lh[i];
+  }
+
+  pso_constant_inertia_init(pso, f, 0.8, 0.1, 0.2, 5., 0.01, DIMENSION,
+                            POPSIZE, 50, 10, bounds_low, bounds_high, vmin,
+                            vmax, SPACE_FILLING_DESIGN_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  for (size_t k = 0; k < DIMENSION; k++)
+  {
+    bounds_low[k] = -500, bounds_high[k] = 700;
+    vmin[k] = -50, vmax[k] = 50;
+  }
+
+  struct pso_data_constant_inertia pso;
+
+  // callbacks, as run_pso
+  init(&pso, &griewank_Nd);
+  pso_constant_inertia_first_steps(&pso, SPACE_FILLING_DESIGN_SIZE,
+                                   space_filling_design);
+  while (pso.time < pso.time_max - 1)
+    pso_constant_inertia_loop(&pso);
+  double run_f = pso.y_hat_eval;
+  size_t run_n = pso.eval_cache.misses;
+  pso_destroy(&pso);
+
+  // ask / tell
+  size_t asked = 0, batches = 0, n;
+  double const *x;
+  init(&pso, NULL);
+  pso_ask_tell_start(&pso, SPACE_FILLING_DESIGN_SIZE, space_filling_design);
+  while ((n = pso_ask(&pso, &x)))
+  {
+    asked += n;
+    batches++;
+    // told twice while the batch is pending, the second tell is ignored
+    if (n > 1)
+      pso_tell(&pso, n - 1, griewank_Nd(x + (n - 1) * DIMENSION));
+    for (size_t k = n; k-- > 0;)
+      pso_tell(&pso, k, griewank_Nd(x + k * DIMENSION));
+  }
+  double ask_f = pso.y_hat_eval;
+  pso_destroy(&pso);
+
+  int ok = !(ask_f < run_f) && !(run_f < ask_f) && asked == run_n;
+  printf("run_pso: f(y) = %f in %zu evaluations\n", run_f, run_n);
+  printf("ask/tell: f(y) = %f in %zu asks, %zu batches %s\n", ask_f, asked,
+         batches, ok ? "ok" : "FAILED");
+  return !ok;
+}
@@ -1,46 +1,104 @@
-
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 #include "rounding_bloom.h"
 #include "helpers.h"
+#include "philox.h"
+
+/*
+ * Pins the rejection radius of the rounding bloom filter: CENTERS points far
+ * apart are added, then PROBES points at each distance r around every one of
+ * them are checked (without adding them). Every point within epsilon has to
+ * be found, and the collision rate further away has to stay under the bounds
+ * documented in rounding_bloom.h.
+ */
+
+#define DIMS 20
+#define CENTERS 256
+#define PROBES 64
+#define EPSILON 0.1
+
+struct radius_test
+{
+    // distance to the center, in units of epsilon
+    double r;
+    // bounds on the fraction of probes reported as collisions
+    double min_rate;
+    double max_rate;
+};
+
+static const struct radius_test radii[] = {
+    {0.5, 1., 1.},   //
+    {1., 1., 1.},    //
+    {2., 0.5, 1.},   //
+    {3., 0., 0.35},  //
+    {4., 0., 0.1},   //
+    {6., 0., 0.02},  //
+    {1e3, 0., 0.02}, // unrelated points, false positives of the filter itself
+};
+
+// A uniform direction scaled to length r, by Box-Muller
+static void random_offset(double const *u, double r, double *dx)
+{
+    double norm = 0.;
+    for (int i = 0; i < DIMS; i++)
+    {
+        dx[i] = sqrt(-2. * log(1. - u[2 * i])) * cos(2. * M_PI * u[2 * i + 1]);
+        norm += dx[i] * dx[i];
+    }
+    for (int i = 0; i < DIMS; i++)
+        dx[i] *= r / sqrt(norm);
+}
 
 int main(int argc, char ** argv)
 {
-    int ret;
-    int dims = 3;
-    double lower_bound[] = {1., 2., 3.};
+    (void)argc;
+    (void)argv;
 
-    struct rounding_bloom b;
-    rounding_bloom_init(&b, 4096, 0.01, 0.1, dims, lower_bound);
+    int failed = 0;
+    double lower_bound[DIMS] = {0};
+    double x[DIMS], dx[DIMS], u[2 * DIMS];
+    double *centers = malloc(CENTERS * DIMS * sizeof(double));
+    struct philox_key key = {0x12345678, 0x9abcdef0};
 
+    struct rounding_bloom b;
+    rounding_bloom_init(&b, 4 * CENTERS, 0.01, EPSILON, DIMS, lower_bound);
     rounding_bloom_print(&b);
 
+    // centers uniform in [0, 1000)^d, thousands of epsilon apart
+    philox_uniform(key, 0, 0, 0, CENTERS * DIMS, centers);
+    for (int c = 0; c < CENTERS * DIMS; c++)
+        centers[c] *= 1000.;
+    for (int c = 0; c < CENTERS; c++)
+        rounding_bloom_check_add(&b, DIMS, centers + c * DIMS, 1);
 
-    int N = 13;
-    double x[] = {
-        1.2,2,3,
-        1.25,2,3,
-        1.29,2,3,
-        1.3,2,3,
-        1.4,2,3,
-        1.5, 2, 3,
-        1.6, 2, 3,
-        1.7, 2, 3,
-        1.8, 2, 3,
-        1.9,2,3,
-        2.0,2,3,
-        2.1,2,3,
-        4.6,2,3,
-        1.e10, 2.e10, 3.e10,
-        1.e10 + 0.05, 2.e10, 3.e10,
-    };
-    for (int i = 0 ; i < N ; i++)
+    for (size_t t = 0; t < sizeof(radii) / sizeof(radii[0]); t++)
     {
-        print_vectord(x + dims * i, dims, "x");
-        ret = rounding_bloom_check_add(&b, dims, x + dims * i, 1);
-        printf("check: %d\n\n", ret);
+        int found = 0;
+        for (int c = 0; c < CENTERS; c++)
+        {
+            for (int p = 0; p < PROBES; p++)
+            {
+                philox_uniform(key, 1 + t, c, p, 2 * DIMS, u);
+                random_offset(u, radii[t].r * EPSILON, dx);
+                for (int i = 0; i < DIMS; i++)
+                    x[i] = centers[c * DIMS + i] + dx[i];
+                found += rounding_bloom_check_add(&b, DIMS, x, 0) != 0;
+            }
+        }
+
+        double rate = (double)found / (CENTERS * PROBES);
+        int ok = radii[t].min_rate <= rate && rate <= radii[t].max_rate;
+        printf("r = %g eps: %d / %d collisions (%.4f) in [%.2f, %.2f] %s\n",
+               radii[t].r, found, CENTERS * PROBES, rate, radii[t].min_rate,
+               radii[t].max_rate, ok ? "ok" : "FAILED");
+        failed |= !ok;
     }
 
     rounding_bloom_free(&b);
-}
\ No newline at end of file
+    free(centers);
+    return failed;
+}
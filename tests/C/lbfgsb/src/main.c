@@ -0,0 +1,205 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "local_refinement.h"
+
+/*
+ * local_optimization_lbfgsb on a nonconvex function, built with a ring of
+ * LOCAL_OPTIMIZATION_MEMORY = 2 pairs (see the Makefile). The same
+ * iteration is rerun below with the pairs kept in a plain list, where a
+ * pair rejected by the curvature test is simply dropped. Some pair has to
+ * be rejected while the ring is full, and both runs have to end at the
+ * same point.
+ */
+
+#define DIMS 4
+#define M LOCAL_OPTIMIZATION_MEMORY
+
+static double fg(double const *const x, double *const g, void const *const args)
+{
+  (void)args;
+  double f = 0;
+  for (int i = 0; i < DIMS; i++)
+  {
+    double c = sin(3. * x[i]), n = cos(2. * x[(i + 1) % DIMS]);
+    f += 0.05 * x[i] * x[i] + c * n;
+    g[i] = 0.1 * x[i] + 3. * cos(3. * x[i]) * n;
+  }
+  for (int i = 0; i < DIMS; i++)
+  {
+    int j = (i + DIMS - 1) % DIMS;
+    g[i] -= 2. * sin(3. * x[j]) * sin(2. * x[i]);
+  }
+  return f;
+}
+
+static double dot(double const *x, double const *y)
+{
+  double s = 0;
+  for (int i = 0; i < DIMS; i++)
+    s += x[i] * y[i];
+  return s;
+}
+
+static double clamp(double x, double lo, double hi)
+{
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// The iteration of local_optimization_lbfgsb, pairs[0] is the newest
+static int reference(double const *center, double xi, double const *a,
+                     double const *b, double *x)
+{
+  double lo[DIMS], hi[DIMS], g[DIMS], x_new[DIMS], g_new[DIMS], p[DIMS];
+  double q[DIMS], s[M][DIMS], y[M][DIMS], rho[M], alpha[M];
+  int free_var[DIMS], n_pairs = 0, rejected_full = 0;
+
+  for (int i = 0; i < DIMS; i++)
+  {
+    lo[i] = fmax(a[i], center[i] - xi);
+    hi[i] = fmin(b[i], center[i] + xi);
+    x[i] = clamp(center[i], lo[i], hi[i]);
+  }
+  double f = fg(x, g, NULL);
+
+  for (int it = 0; it < LOCAL_OPTIMIZATION_ITERATIONS; it++)
+  {
+    double pg_norm = 0;
+    for (int i = 0; i < DIMS; i++)
+    {
+      int held = (x[i] <= lo[i] && g[i] > 0) || (x[i] >= hi[i] && g[i] < 0);
+      free_var[i] = !held;
+      p[i] = held ? 0 : -g[i];
+      pg_norm = fmax(pg_norm, fabs(clamp(x[i] - g[i], lo[i], hi[i]) - x[i]));
+    }
+    if (pg_norm <= LOCAL_OPTIMIZATION_TOLERANCE)
+      break;
+
+    memcpy(q, p, sizeof(q));
+    for (int j = 0; j < n_pairs; j++)
+    {
+      alpha[j] = rho[j] * dot(s[j], q);
+      for (int i = 0; i < DIMS; i++)
+        q[i] -= alpha[j] * y[j][i];
+    }
+    if (n_pairs > 0)
+    {
+      double gamma = dot(s[0], y[0]) / dot(y[0], y[0]);
+      for (int i = 0; i < DIMS; i++)
+        q[i] *= gamma;
+    }
+    for (int j = n_pairs - 1; j >= 0; j--)
+    {
+      double beta = rho[j] * dot(y[j], q);
+      for (int i = 0; i < DIMS; i++)
+        q[i] += (alpha[j] - beta) * s[j][i];
+    }
+    double q_g = 0;
+    for (int i = 0; i < DIMS; i++)
+      if (free_var[i])
+        q_g += q[i] * g[i];
+    if (n_pairs > 0 && q_g < 0)
+      for (int i = 0; i < DIMS; i++)
+        p[i] = free_var[i] ? q[i] : 0;
+
+    double t = 1;
+    if (n_pairs == 0)
+    {
+      double p_max = 0;
+      for (int i = 0; i < DIMS; i++)
+        p_max = fmax(p_max, fabs(p[i]));
+      t = fmin(1., xi / p_max);
+    }
+
+    double f_new = f;
+    int accepted = 0;
+    for (int ls = 0; ls < LOCAL_OPTIMIZATION_LINE_SEARCH && !accepted; ls++)
+    {
+      for (int i = 0; i < DIMS; i++)
+        x_new[i] = clamp(x[i] + t * p[i], lo[i], hi[i]);
+      f_new = fg(x_new, g_new, NULL);
+
+      double decrease = 0;
+      for (int i = 0; i < DIMS; i++)
+        decrease += g[i] * (x_new[i] - x[i]);
+      accepted = f_new <= f + 1e-4 * decrease;
+      t *= 0.5;
+    }
+    if (!accepted)
+      break;
+
+    double s_new[DIMS], y_new[DIMS];
+    for (int i = 0; i < DIMS; i++)
+    {
+      s_new[i] = x_new[i] - x[i];
+      y_new[i] = g_new[i] - g[i];
+    }
+    double sy = dot(s_new, y_new);
+    if (sy > 1e-10 * dot(y_new, y_new))
+    {
+      // drop the oldest pair, the new one goes in front
+      for (int j = (n_pairs < M ? n_pairs : M - 1); j > 0; j--)
+      {
+        memcpy(s[j], s[j - 1], sizeof(s[j]));
+        memcpy(y[j], y[j - 1], sizeof(y[j]));
+        rho[j] = rho[j - 1];
+      }
+      memcpy(s[0], s_new, sizeof(s_new));
+      memcpy(y[0], y_new, sizeof(y_new));
+      rho[0] = 1. / sy;
+      if (n_pairs < M)
+        n_pairs++;
+    }
+    else if (n_pairs == M)
+    {
+      rejected_full++;
+    }
+
+    memcpy(x, x_new, sizeof(x_new));
+    memcpy(g, g_new, sizeof(g_new));
+    f = f_new;
+  }
+  return rejected_full;
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  double a[DIMS], b[DIMS], center[DIMS];
+  double x_min[DIMS], x_ref[DIMS];
+  double *work = malloc(LOCAL_OPTIMIZATION_WORK_SIZE(DIMS) * sizeof(double));
+  int failed = 0, rejections = 0;
+
+  for (int start = 0; start < 16; start++)
+  {
+    for (int i = 0; i < DIMS; i++)
+    {
+      a[i] = -10., b[i] = 10.;
+      center[i] = sin(7. * start + 3. * i) * 4.;
+    }
+
+    local_optimization_lbfgsb(&fg, DIMS, center, 3., a, b, NULL, x_min, work);
+    int rejected = reference(center, 3., a, b, x_ref);
+    rejections += rejected;
+
+    double err = 0;
+    for (int i = 0; i < DIMS; i++)
+      err = fmax(err, fabs(x_min[i] - x_ref[i]));
+    int ok = err <= 1e-12;
+    printf("start %d: %d pairs rejected with a full ring, |x - x_ref| = %.2e "
+           "%s\n",
+           start, rejected, err, ok ? "ok" : "FAILED");
+    failed |= !ok;
+  }
+
+  printf("%d pairs rejected with a full ring %s\n", rejections,
+         rejections ? "ok" : "FAILED");
+  failed |= !rejections;
+
+  free(work);
+  return failed;
+}
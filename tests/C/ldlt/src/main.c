@@ -0,0 +1,156 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "ldlt_solve.h"
+#include "philox.h"
+#include "solver_context.h"
+
+/*
+ * Residual test of the LDL^T solvers on the surrogate system
+ * [0 P^T; P Phi] of random points, Phi the cubic kernel. The system is
+ * solved with ldlt_solve from scratch, then grown by BATCH points at a time
+ * with ldlt_factor_border (refactoring whenever it rejects the border) and
+ * solved with ldlt_solve_factored after every batch. The normwise backward
+ * error |b - A x| / (|A| |x| + |b|) has to stay under TOL every time.
+ *
+ * A last batch repeats a point up to DUPLICATE_DIST, which makes the Schur
+ * complement nearly singular: the border has to be rejected.
+ */
+
+#define DIMS 5
+#define N_P (DIMS + 1)
+#define MAX_POINTS 400
+#define BATCH 20
+#define MAX_N (MAX_POINTS + N_P)
+#define TOL 1e-12
+#define DUPLICATE_DIST 1e-9
+
+static double points[MAX_POINTS * DIMS];
+
+// A(i, j) of the full symmetric system
+static double entry(int i, int j)
+{
+  if (i < j)
+    return entry(j, i);
+  if (i < N_P)
+    return 0.;
+  if (j == 0)
+    return 1.;
+  if (j < N_P)
+    return points[(i - N_P) * DIMS + j - 1];
+
+  double r2 = 0.;
+  for (int k = 0; k < DIMS; k++)
+  {
+    double d = points[(i - N_P) * DIMS + k] - points[(j - N_P) * DIMS + k];
+    r2 += d * d;
+  }
+  return r2 * sqrt(r2);
+}
+
+// Write the lower triangle of rows N0 : N of the system into A
+static void assemble(int N0, int N, double *A, int LDA)
+{
+  for (int i = N0; i < N; i++)
+    for (int j = 0; j <= i; j++)
+      TIX(A, LDA, i, j) = entry(i, j);
+}
+
+static double backward_error(int N, double const *b, double const *x)
+{
+  double r = 0., a = 0., xn = 0., bn = 0.;
+  for (int i = 0; i < N; i++)
+  {
+    double ri = b[i], ai = 0.;
+    for (int j = 0; j < N; j++)
+    {
+      ri -= entry(i, j) * x[j];
+      ai += fabs(entry(i, j));
+    }
+    r = MAX(r, fabs(ri));
+    a = MAX(a, ai);
+    xn = MAX(xn, fabs(x[i]));
+    bn = MAX(bn, fabs(b[i]));
+  }
+  return r / (a * xn + bn);
+}
+
+static void rhs(int N, double *b)
+{
+  for (int i = 0; i < N; i++)
+    b[i] = i < N_P ? 0. : sin((double)i);
+}
+
+static int check(const char *what, int N, double const *b, double const *x)
+{
+  double err = backward_error(N, b, x);
+  int ok = err <= TOL;
+  printf("%s N = %d: backward error %.2e %s\n", what, N, err,
+         ok ? "ok" : "FAILED");
+  return !ok;
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  int failed = 0, ret;
+  int *ipiv = malloc(MAX_N * sizeof(int));
+  double *A = malloc((size_t)MAX_N * MAX_N * sizeof(double));
+  double *b = malloc(MAX_N * sizeof(double));
+  double *x = malloc(MAX_N * sizeof(double));
+  struct philox_key key = {0x2468ace0, 0x13579bdf};
+
+  struct solver_context *ctx = solver_context_alloc();
+  ldlt_initialize_memory(ctx, MAX_N);
+
+  philox_uniform(key, 0, 0, 0, MAX_POINTS * DIMS, points);
+
+  // From scratch, LDA = N
+  int N = MAX_N - BATCH;
+  assemble(0, N, A, N);
+  rhs(N, b);
+  memcpy(x, b, N * sizeof(double));
+  ret = ldlt_solve(ctx, N, A, x);
+  failed |= ret != 0 || check("ldlt_solve", N, b, x);
+
+  // Grown a batch at a time in place, LDA = MAX_N
+  int refactored = 0, K;
+  for (N = 0, K = N_P + BATCH; N + K <= MAX_N - BATCH; N += K, K = BATCH)
+  {
+    assemble(N, N + K, A, MAX_N);
+    ret = ldlt_factor_border(ctx, N, K, A, MAX_N, ipiv);
+    if (ret != 0)
+    {
+      refactored++;
+      assemble(0, N + K, A, MAX_N);
+      ret = ldlt_factor(ctx, N + K, A, MAX_N, ipiv);
+    }
+    rhs(N + K, b);
+    memcpy(x, b, (N + K) * sizeof(double));
+    failed |= ret != 0 ||
+              ldlt_solve_factored(ctx, N + K, A, MAX_N, ipiv, x) != 0 ||
+              check("ldlt_factor_border", N + K, b, x);
+  }
+  printf("%d borders rejected\n", refactored);
+
+  // The last batch nearly repeats its first point
+  memcpy(points + (N - N_P) * DIMS, points, DIMS * sizeof(double));
+  points[(N - N_P) * DIMS] += DUPLICATE_DIST;
+  assemble(N, N + BATCH, A, MAX_N);
+  ret = ldlt_factor_border(ctx, N, BATCH, A, MAX_N, ipiv);
+  printf("near duplicate point: ldlt_factor_border returned %d %s\n", ret,
+         ret != 0 ? "ok" : "FAILED");
+  failed |= ret == 0;
+
+  solver_context_destroy(ctx);
+  free(x);
+  free(b);
+  free(A);
+  free(ipiv);
+  return failed;
+}
@@ -8,13 +8,16 @@ include("TestUtils.jl")
 
 const tu = TestUtils
 
+# struct solver_context * of each library, created by init
+const contexts = Dict{Ptr{Cvoid}, Ptr{Cvoid}}()
+
 function lu_solve(lib, N, A, b)
     GC.@preserve A b begin
         retcode = ccall(
             tu.lookup(lib, :lu_solve),
             Cint,
-            (Cint, Ptr{Cdouble}, Ptr{Cdouble}),
-            N, A, b
+            (Ptr{Cvoid}, Cint, Ptr{Cdouble}, Ptr{Cdouble}),
+            contexts[lib], N, A, b
         )
     end
     return retcode
@@ -80,11 +83,16 @@ function setup(n, A, b)
 end
 
 function init(lb, n)
-    ccall(tu.lookup(lb, :lu_initialize_memory), Cvoid, (Cint,), n)
+    ctx = ccall(tu.lookup(lb, :solver_context_alloc), Ptr{Cvoid}, ())
+    @assert ctx != C_NULL
+    ccall(tu.lookup(lb, :lu_initialize_memory), Cvoid, (Ptr{Cvoid}, Cint),
+          ctx, n)
+    contexts[lb] = ctx
 end
 
-function teardown(lb)
-    ccall(tu.lookup(lb, :lu_free_memory), Cvoid, ())
+function teardown(lb=tu.libpso)
+    ctx = pop!(contexts, lb)
+    ccall(tu.lookup(lb, :solver_context_destroy), Cvoid, (Ptr{Cvoid},), ctx)
 end
 
 function valid(lib, n, A, b)
@@ -101,8 +109,8 @@ function perf_tests(lib, n, A, b)
         retcode = ccall(
             tu.lookup(lib, :perf_test_lu_solve),
             Cint,
-            (Csize_t, Ptr{Cdouble}, Ptr{Cdouble}),
-            n, A_vec, b_vec
+            (Ptr{Cvoid}, Cint, Ptr{Cdouble}, Ptr{Cdouble}),
+            contexts[lib], n, A_vec, b_vec
         )
         @assert retcode == 0
     end
@@ -29,6 +29,12 @@ end
 function perf_tests(lib, m, n, k)
     (A, LDA, B, LDB, C, LDC) = setup(m, n, k)
     tu.starting_test(@sprintf "MMM perf comparison with A[%d, %d] B[%d %d] C[%d %d]" m k k n m n)
+    # packing workspace of the dgemm kernels
+    ctx = ccall(tu.lookup(lib, :solver_context_alloc), Ptr{Cvoid}, ())
+    @assert ctx != C_NULL
+    work = ccall(tu.lookup(lib, :solver_context_dgemm_work), Ptr{Cdouble},
+                 (Ptr{Cvoid},), ctx)
+    @assert work != C_NULL
     # NOTE this preserve shouldn't be necessary because
     # a Ptr{Cdouble} Base.unsafe_convert already exists.
     GC.@preserve A B C begin
@@ -38,10 +44,12 @@ function perf_tests(lib, m, n, k)
           (Cint, Cint, Cint, Cdouble,
             Ptr{Cdouble}, Cint,
             Ptr{Cdouble}, Cint,
-            Cdouble, Ptr{Cdouble}, Cint),
-          m, n, k, -1.0, A, LDA, B, LDB, 1.0, C, LDC
+            Cdouble, Ptr{Cdouble}, Cint,
+            Ptr{Cdouble}),
+          m, n, k, -1.0, A, LDA, B, LDB, 1.0, C, LDC, work
         )
     end
+    ccall(tu.lookup(lib, :solver_context_destroy), Cvoid, (Ptr{Cvoid},), ctx)
 end
 
 
@@ -99,7 +99,7 @@ function autotuning_lu_main(libs_to_perf)
     end
     for lib_symbol in libs_to_perf
         tu.set_lib(lib_symbol)
-        LU.teardown(lib_symbol)
+        LU.teardown(tu.libpso)
     end
 end
 